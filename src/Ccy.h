@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <iostream>
+#include <functional>
+
+#include "Macros.h"
+
+namespace minirisk {
+
+// ISO 4217 currency code packed in an integer: copying, comparing and hashing are integer
+// operations, and a code never allocates. The first letter is in the most significant byte,
+// so that codes sort in alphabetical order.
+struct Ccy
+{
+    constexpr Ccy() : m_code(0) {}
+
+    // from a literal, e.g. Ccy("USD"), checked at compile time when constexpr
+    constexpr Ccy(const char (&s)[4])
+        : m_code(pack(s[0], s[1], s[2]))
+    {
+    }
+
+    // from a string, which must have exactly 3 characters
+    explicit Ccy(const std::string& s)
+    {
+        MYASSERT(s.length() == 3, "Currency code must be 3 characters (ISO 4217 code), got: " << s);
+        m_code = pack(s[0], s[1], s[2]);
+    }
+
+    constexpr bool empty() const { return m_code == 0; }
+    constexpr uint32_t code() const { return m_code; }
+
+    constexpr char operator[](size_t i) const { return static_cast<char>(m_code >> (8 * (2 - i))); }
+
+    std::string str() const
+    {
+        return empty() ? std::string() : std::string{ (*this)[0], (*this)[1], (*this)[2] };
+    }
+
+    // append the code to s (no allocation if s has enough capacity)
+    void append_to(std::string& s) const
+    {
+        if (!empty())
+            s.append({ (*this)[0], (*this)[1], (*this)[2] });
+    }
+
+    constexpr bool operator==(Ccy c) const { return m_code == c.m_code; }
+    constexpr bool operator!=(Ccy c) const { return m_code != c.m_code; }
+    constexpr bool operator<(Ccy c) const { return m_code < c.m_code; }
+
+private:
+    static constexpr uint32_t pack(char c0, char c1, char c2)
+    {
+        return (uint32_t(uint8_t(c0)) << 16) | (uint32_t(uint8_t(c1)) << 8) | uint32_t(uint8_t(c2));
+    }
+
+    uint32_t m_code;
+};
+
+static_assert(sizeof(Ccy) == 4, "Ccy must be packed in 32 bits");
+
+inline std::ostream& operator<<(std::ostream& os, Ccy c)
+{
+    if (!c.empty())
+        os << c[0] << c[1] << c[2];
+    return os;
+}
+
+// Fibonacci hashing of the code
+struct CcyHash
+{
+    size_t operator()(Ccy c) const noexcept
+    {
+        return static_cast<size_t>(c.code() * 0x9E3779B97F4A7C15ull >> 16);
+    }
+};
+
+} // namespace minirisk
+
+template <>
+struct std::hash<minirisk::Ccy> : minirisk::CcyHash {};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <array>
+
+namespace minirisk {
+
+// Counter-based random number generator Philox4x32-10 (Salmon et al., "Parallel random
+// numbers: as easy as 1, 2, 3", SC11). The output is a pure function of a 128 bit counter and
+// a 64 bit key: a simulation numbering its draws by counter, e.g. (path, date, variable),
+// gets the same numbers whichever thread makes each draw and in whichever order, without any
+// generator state to share or to skip ahead.
+struct CounterRng
+{
+    typedef std::array<uint32_t, 4> counter_t;
+
+    explicit constexpr CounterRng(uint64_t seed)
+        : m_key{ static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32) }
+    {
+    }
+
+    // 128 random bits of a counter
+    constexpr counter_t operator()(counter_t c) const
+    {
+        uint32_t k0 = m_key[0], k1 = m_key[1];
+        for (int r = 0; r < 10; ++r) {
+            if (r > 0) {
+                k0 += W0;
+                k1 += W1;
+            }
+            const uint64_t p0 = uint64_t(M0) * c[0];
+            const uint64_t p1 = uint64_t(M1) * c[2];
+            c = { uint32_t(p1 >> 32) ^ c[1] ^ k0, uint32_t(p1), uint32_t(p0 >> 32) ^ c[3] ^ k1, uint32_t(p0) };
+        }
+        return c;
+    }
+
+    // two independent standard normal draws of a counter (Box-Muller on two 53 bit uniforms)
+    void normals(const counter_t& c, double& z0, double& z1) const
+    {
+        const counter_t x = (*this)(c);
+        const double u0 = to_uniform(x[0], x[1]);
+        const double u1 = to_uniform(x[2], x[3]);
+        const double r = std::sqrt(-2.0 * std::log(u0));
+        const double theta = 6.283185307179586 * u1;
+        z0 = r * std::cos(theta);
+        z1 = r * std::sin(theta);
+    }
+
+private:
+    // uniform in (0, 1): 53 random bits, offset by half a step so that 0 is never drawn
+    static constexpr double to_uniform(uint32_t hi, uint32_t lo)
+    {
+        const uint64_t bits = (uint64_t(hi) << 21) ^ (lo >> 11);
+        return (double(bits) + 0.5) * (1.0 / 9007199254740992.0);
+    }
+
+    static constexpr uint32_t M0 = 0xD2511F53;
+    static constexpr uint32_t M1 = 0xCD9E8D57;
+    static constexpr uint32_t W0 = 0x9E3779B9;     // golden ratio
+    static constexpr uint32_t W1 = 0xBB67AE85;     // sqrt(3) - 1
+
+    std::array<uint32_t, 2> m_key;
+};
+
+// known answer of the reference implementation (Random123), counter and key all zero
+static_assert(CounterRng(0)({ 0, 0, 0, 0 }) == CounterRng::counter_t{ 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 },
+    "Philox4x32-10 known answer");
+
+} // namespace minirisk
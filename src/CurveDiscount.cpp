@@ -1,9 +1,12 @@
 #include "CurveDiscount.h"
 #include "Market.h"
 #include "Streamer.h"
+#include "PerfCounters.h"
+#include "Trace.h"
+#include "LatencyHistogram.h"
 
 #include <cmath>
-#include <regex>
+#include <charconv>
 #include <algorithm>
 
 
@@ -25,24 +28,33 @@ static unsigned tenor_to_days(unsigned n, char unit)
 CurveDiscount::CurveDiscount(const Market *mkt, const Date& today, const string& curve_name)
     : m_today(today)
     , m_name(curve_name)
+    , m_T(mkt->memory_resource())
+    , m_r(mkt->memory_resource())
+    , m_rT_prefix(mkt->memory_resource())
+    , m_r_local(mkt->memory_resource())
 {
+    trace::ScopedEvent event(curve_name, "curve");
+    perf::ScopedLatency latency(perf::lat_curve_discount);
+
     string ccy = curve_name.substr(ir_curve_discount_prefix.length(), 3);
 
-    std::regex pattern(std::string("^IR\\.([0-9]+)([DWMY])\\.") + ccy + "$");
-    auto keys = mkt->match_keys(std::string("^IR\\.[0-9]+[DWMY]\\.") + ccy + "$" );
+    const auto& keys = mkt->ir_tenor_keys(ccy);
 
-    std::vector<std::pair<unsigned,double>> grid;
+    // temporary, in the same memory as the curve
+    std::pmr::vector<std::pair<unsigned,double>> grid(mkt->memory_resource());
     grid.reserve(keys.size());
 
+    // the keys are known to be well formed, so the tenor is parsed directly: IR.<n><unit>.<ccy>
+    const size_t prefix_len = ir_rate_prefix.length();
     for (const auto& key : keys) {
-        std::smatch m;
-        if (std::regex_match(key, m, pattern)) {
-            unsigned n = static_cast<unsigned>(std::stoul(m[1].str()));
-            char unit = m[2].str()[0];
-            unsigned days = tenor_to_days(n, unit);
-            double r = mkt->get_value(key, "yield");
-            grid.emplace_back(days, r);
-        }
+        const char* first = key.data() + prefix_len;
+        const char* last = key.data() + key.size() - ccy.size() - 2;  // the unit
+        unsigned n = 0;
+        auto res = std::from_chars(first, last, n);
+        MYASSERT(res.ec == std::errc() && res.ptr == last, "Invalid tenor in risk factor " << key);
+        unsigned days = tenor_to_days(n, *last);
+        double r = mkt->get_value(key, "yield");
+        grid.emplace_back(days, r);
     }
 
     MYASSERT(!grid.empty(), "No tenor points found for curve " << curve_name);
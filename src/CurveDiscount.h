@@ -1,5 +1,7 @@
 #pragma once
 #include "ICurve.h"
+#include <vector>
+#include <memory_resource>
 
 namespace minirisk {
 
@@ -20,10 +22,11 @@ private:
     Date   m_today;
     string m_name;
 
-    std::vector<unsigned> m_T;
-    std::vector<double>   m_r;
-    std::vector<double>   m_rT_prefix;
-    std::vector<double>   m_r_local;
+    // allocated in the memory resource of the market (an arena for bumped markets)
+    std::pmr::vector<unsigned> m_T;
+    std::pmr::vector<double>   m_r;
+    std::pmr::vector<double>   m_rT_prefix;
+    std::pmr::vector<double>   m_r_local;
     
 };
 
@@ -3,6 +3,8 @@
 #include "CurveDiscount.h"
 #include "Macros.h"
 #include "Global.h"
+#include "Trace.h"
+#include "LatencyHistogram.h"
 
 namespace minirisk {
 
@@ -11,20 +13,26 @@ CurveFXForward::CurveFXForward(const Market* mkt, const Date& today, const strin
     , m_today(today)
     , m_name(name)
 {
+    trace::ScopedEvent event(name, "curve");
+    perf::ScopedLatency latency(perf::lat_curve_fx_forward);
+
     // Expected naming: "FX.FWD.CCY1.CCY2"
     // Parse to extract CCY1 and CCY2
+    auto to_ccy = [&name](const string& s) {
+        MYASSERT(s.length() == 3, "Invalid FX forward curve name format: " << name);
+        return Ccy(s);
+    };
     size_t first_dot = name.find('.');
     size_t second_dot = (first_dot == string::npos) ? string::npos : name.find('.', first_dot + 1);
     size_t third_dot = (second_dot == string::npos) ? string::npos : name.find('.', second_dot + 1);
     MYASSERT(third_dot != string::npos, "Invalid FX forward curve name format: " << name);
     size_t fourth_dot = name.find('.', third_dot + 1);
-    m_ccy1 = name.substr(third_dot + 1, (fourth_dot == string::npos ? name.size() : fourth_dot) - (third_dot + 1));
-    if (fourth_dot != string::npos)
-        m_ccy2 = name.substr(fourth_dot + 1);
-    else {
-        size_t last_dot = name.find_last_of('.');
-        m_ccy2 = name.substr(last_dot + 1);
-        m_ccy1 = name.substr(second_dot + 1, third_dot - second_dot - 1);
+    if (fourth_dot != string::npos) {
+        m_ccy1 = to_ccy(name.substr(third_dot + 1, fourth_dot - (third_dot + 1)));
+        m_ccy2 = to_ccy(name.substr(fourth_dot + 1));
+    } else {
+        m_ccy1 = to_ccy(name.substr(second_dot + 1, third_dot - second_dot - 1));
+        m_ccy2 = to_ccy(name.substr(third_dot + 1));
     }
 
     MYASSERT(!m_ccy1.empty() && !m_ccy2.empty(), "Invalid FX forward curve name format: " << name);
@@ -17,8 +17,8 @@ private:
     const Market* m_mkt;
     Date m_today;
     string m_name;
-    string m_ccy1;
-    string m_ccy2;
+    Ccy m_ccy1;
+    Ccy m_ccy2;
 };
 
 } // namespace minirisk
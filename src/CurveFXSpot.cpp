@@ -15,6 +15,10 @@ CurveFXSpot::CurveFXSpot(const Market* mkt, const Date& today, const string& nam
     // Supported formats:
     //  - "FX.SPOT.CCY1.CCY2" (general pair)
     //  - "FX.SPOT.CCY1" (interpreted as CCY1/USD)
+    auto to_ccy = [&name](const string& s) {
+        MYASSERT(s.length() == 3, "Invalid FX spot curve name format: " << name);
+        return Ccy(s);
+    };
     size_t first_dot = name.find('.');
     size_t second_dot = (first_dot == string::npos) ? string::npos : name.find('.', first_dot + 1);
     size_t third_dot = (second_dot == string::npos) ? string::npos : name.find('.', second_dot + 1);
@@ -22,20 +26,17 @@ CurveFXSpot::CurveFXSpot(const Market* mkt, const Date& today, const string& nam
         // General pair FX.SPOT.CCY1.CCY2
         size_t fourth_dot = name.find('.', third_dot + 1);
         // Expect no fourth dot; tokens: FX, SPOT, CCY1, CCY2
-        m_ccy1 = name.substr(third_dot + 1, (fourth_dot == string::npos ? name.size() : fourth_dot) - (third_dot + 1));
-        // Extract CCY2 after the next dot if present, otherwise already captured
         if (fourth_dot != string::npos) {
-            m_ccy2 = name.substr(fourth_dot + 1);
+            m_ccy1 = to_ccy(name.substr(third_dot + 1, fourth_dot - (third_dot + 1)));
+            m_ccy2 = to_ccy(name.substr(fourth_dot + 1));
         } else {
-            // No extra dot, m_ccy1 actually holds CCY1, need to find CCY2 after the third dot
-            size_t last_dot = name.find_last_of('.');
-            m_ccy2 = name.substr(last_dot + 1);
-            // Fix m_ccy1 to be token between second and third dots
-            m_ccy1 = name.substr(second_dot + 1, third_dot - second_dot - 1);
+            // CCY1 is the token between second and third dots, CCY2 follows the third dot
+            m_ccy1 = to_ccy(name.substr(second_dot + 1, third_dot - second_dot - 1));
+            m_ccy2 = to_ccy(name.substr(third_dot + 1));
         }
     } else if (second_dot != string::npos) {
         // Short form FX.SPOT.CCY1 (interpreted as CCY1/USD)
-        m_ccy1 = name.substr(second_dot + 1);
+        m_ccy1 = to_ccy(name.substr(second_dot + 1));
         m_ccy2 = "USD";
     }
     
@@ -1,33 +1,9 @@
 #include "Date.h"
-#include <iomanip>
-#include <sstream>
+#include <charconv>
 #include <stdexcept>
 
 namespace minirisk {
 
-struct DateInitializer : std::array<unsigned, Date::N_YEARS> {
-    DateInitializer() {
-        for (unsigned i = 0, cumulative_days = 0, year = Date::FIRST_YEAR; 
-             i < size(); ++i, ++year) {
-            (*this)[i] = cumulative_days;
-            cumulative_days += 365 + (Date::is_leap_year(year) ? 1 : 0);
-        }
-    }
-};
-
-const std::array<unsigned, 12> Date::DAYS_IN_MONTH = {
-    {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31}
-};
-
-const std::array<unsigned, 12> Date::DAYS_YTD = {
-    {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334}
-};
-
-const std::array<unsigned, Date::N_YEARS> Date::DAYS_EPOCH(
-    static_cast<const std::array<unsigned, Date::N_YEARS>&>(DateInitializer())
-);
-
-
 Date::Date(unsigned year, unsigned month, unsigned day) {
     init(year, month, day);
 }
@@ -38,61 +14,22 @@ void Date::init(unsigned year, unsigned month, unsigned day) {
 }
 
 std::string Date::to_string(bool pretty) const {
-    unsigned year, month, day;
-    serial_to_calendar(year, month, day);
-    
+    char buf[32];
+    char* p = buf;
     if (pretty) {
-        return std::to_string(day) + "-" + 
-               std::to_string(month) + "-" + 
-               std::to_string(year);
+        // d-m-yyyy: each field leaves room for the separator after it
+        unsigned year, month, day;
+        serial_to_calendar(year, month, day);
+        char* end = buf + sizeof(buf);
+        p = std::to_chars(p, end - 1, day).ptr;
+        *p++ = '-';
+        p = std::to_chars(p, end - 1, month).ptr;
+        *p++ = '-';
+        p = std::to_chars(p, end, year).ptr;
     } else {
-        return std::to_string(year) + 
-               padding_dates(month) + 
-               padding_dates(day);
-    }
-}
-
-void Date::serial_to_calendar(unsigned& year, unsigned& month, unsigned& day) const {
-
-    unsigned year_index = 0;
-    for (unsigned i = 0; i < N_YEARS; ++i) {
-        if (DAYS_EPOCH[i] > m_serial) {
-            year_index = i - 1;
-            break;
-        }
-        year_index = i;
+        p = format_yyyymmdd(p);
     }
-    
-    year = FIRST_YEAR + year_index;
-    
-    unsigned remaining_days = m_serial - DAYS_EPOCH[year_index];
-    
-    month = 1;
-    for (unsigned m = 0; m < 12; ++m) {
-        unsigned days_in_month = DAYS_IN_MONTH[m];
-        if (m == 1 && is_leap_year(year)) {
-            days_in_month = 29;
-        }
-        
-        if (remaining_days < days_in_month) {
-            month = m + 1;
-            break;
-        }
-        remaining_days -= days_in_month;
-    }
-    
-    day = remaining_days + 1;
-}
-
-unsigned Date::calendar_to_serial(unsigned year, unsigned month, unsigned day) {
-    return DAYS_EPOCH[year - FIRST_YEAR] + 
-           DAYS_YTD[month - 1] + 
-           ((month > 2 && is_leap_year(year)) ? 1 : 0) + 
-           (day - 1);
-}
-
-bool Date::is_leap_year(unsigned year) {
-    return (year % 4 == 0) && ((year % 100 != 0) || (year % 400 == 0));
+    return std::string(buf, p);
 }
 
 void Date::check_valid(unsigned year, unsigned month, unsigned day) {
@@ -127,12 +64,6 @@ void Date::check_valid(unsigned year, unsigned month, unsigned day) {
 }
 
 
-std::string Date::padding_dates(unsigned value) {
-    std::ostringstream os;
-    os << std::setw(2) << std::setfill('0') << value;
-    return os.str();
-}
-
 long operator-(const Date& d1, const Date& d2) {
     return static_cast<long>(d1.m_serial) - static_cast<long>(d2.m_serial);
 }
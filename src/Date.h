@@ -3,6 +3,7 @@
 #include "Macros.h"
 #include <string>
 #include <array>
+#include <cstddef>
 
 namespace minirisk {
 
@@ -14,6 +15,9 @@ public:
     static constexpr unsigned N_YEARS = LAST_YEAR - FIRST_YEAR;
     static constexpr unsigned DEFAULT_SERIAL = 25567;
 
+    // number of characters of a date in YYYYMMDD format
+    static constexpr size_t YYYYMMDD_SIZE = 8;
+
     Date() : m_serial(DEFAULT_SERIAL) {}
     Date(unsigned serial) : m_serial(serial) {}
     Date(unsigned year, unsigned month, unsigned day);
@@ -21,8 +25,66 @@ public:
     void init(unsigned year, unsigned month, unsigned day);
     unsigned serial() const { return m_serial; }
     std::string to_string(bool pretty = true) const;
-    void serial_to_calendar(unsigned& year, unsigned& month, unsigned& day) const;
-    static unsigned calendar_to_serial(unsigned year, unsigned month, unsigned day);
+
+    constexpr void serial_to_calendar(unsigned& year, unsigned& month, unsigned& day) const
+    {
+        serial_to_calendar(m_serial, year, month, day);
+    }
+
+    // Closed-form conversions (days from civil and civil from days, on a calendar starting in
+    // March so that the leap day is the last day of the year): O(1), without tables or loops.
+    static constexpr void serial_to_calendar(unsigned serial, unsigned& year, unsigned& month, unsigned& day)
+    {
+        const unsigned z = serial + EPOCH_SHIFT;                                  // days since 0000-03-01
+        const unsigned era = z / 146097;
+        const unsigned doe = z - era * 146097;                                    // [0, 146096]
+        const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365; // [0, 399]
+        const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);             // [0, 365]
+        const unsigned mp = (5 * doy + 2) / 153;                                  // [0, 11], 0 is March
+        day = doy - (153 * mp + 2) / 5 + 1;
+        month = mp < 10 ? mp + 3 : mp - 9;
+        year = yoe + era * 400 + (month <= 2);
+    }
+
+    static constexpr unsigned calendar_to_serial(unsigned year, unsigned month, unsigned day)
+    {
+        const unsigned y = year - (month <= 2);
+        const unsigned era = y / 400;
+        const unsigned yoe = y - era * 400;
+        const unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + doe - EPOCH_SHIFT;
+    }
+
+    // Write the date as YYYYMMDD (exactly YYYYMMDD_SIZE characters, not null terminated) and
+    // return the end of the written characters.
+    constexpr char* format_yyyymmdd(char* p) const
+    {
+        unsigned year, month, day;
+        serial_to_calendar(year, month, day);
+        const unsigned digits[YYYYMMDD_SIZE] = {
+            year / 1000, year / 100 % 10, year / 10 % 10, year % 10,
+            month / 10, month % 10, day / 10, day % 10 };
+        for (size_t i = 0; i < YYYYMMDD_SIZE; ++i)
+            p[i] = static_cast<char>('0' + digits[i]);
+        return p + YYYYMMDD_SIZE;
+    }
+
+    // Read YYYYMMDD_SIZE characters as YYYYMMDD. Returns false if any of them is not a digit,
+    // without checking that the date is valid (see check_valid).
+    static constexpr bool parse_yyyymmdd(const char* p, unsigned& year, unsigned& month, unsigned& day)
+    {
+        unsigned d[YYYYMMDD_SIZE] = {};
+        bool ok = true;
+        for (size_t i = 0; i < YYYYMMDD_SIZE; ++i) {
+            d[i] = static_cast<unsigned>(static_cast<unsigned char>(p[i])) - '0';
+            ok &= d[i] < 10;
+        }
+        year = d[0] * 1000 + d[1] * 100 + d[2] * 10 + d[3];
+        month = d[4] * 10 + d[5];
+        day = d[6] * 10 + d[7];
+        return ok;
+    }
 
     
     bool operator<(const Date& other) const { return m_serial < other.m_serial; }
@@ -32,26 +94,35 @@ public:
     bool operator==(const Date& other) const { return m_serial == other.m_serial; }
     bool operator!=(const Date& other) const { return m_serial != other.m_serial; }
 
-    static bool is_leap_year(unsigned year);
+    static constexpr bool is_leap_year(unsigned year)
+    {
+        return (year % 4 == 0) && ((year % 100 != 0) || (year % 400 == 0));
+    }
+
     static void check_valid(unsigned year, unsigned month, unsigned day);
 
 private:
     
     unsigned m_serial;  ///< Number of days since January 1, 1900
-    
-    static const std::array<unsigned, 12> DAYS_IN_MONTH;  ///< Days in each month (normal year)
-    static const std::array<unsigned, 12> DAYS_YTD;       ///< Cumulative days to start of each month
-    static const std::array<unsigned, N_YEARS> DAYS_EPOCH; ///< Cumulative days to start of each year
-    
-    static std::string padding_dates(unsigned value);
+
+    static constexpr unsigned EPOCH_SHIFT = 693901;  ///< Days from 0000-03-01 to 1900-01-01
+
+    static constexpr std::array<unsigned, 12> DAYS_IN_MONTH = {
+        {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31}
+    };  ///< Days in each month (normal year)
     
     friend long operator-(const Date& d1, const Date& d2);
 };
 
+static_assert(Date::calendar_to_serial(Date::FIRST_YEAR, 1, 1) == 0, "Serial 0 must be January 1, 1900");
+static_assert(Date::calendar_to_serial(1970, 1, 1) == Date::DEFAULT_SERIAL, "Default serial must be January 1, 1970");
+static_assert(Date::calendar_to_serial(2000, 3, 1) - Date::calendar_to_serial(2000, 2, 28) == 2, "2000 is a leap year");
+static_assert(Date::calendar_to_serial(2100, 3, 1) - Date::calendar_to_serial(2100, 2, 28) == 1, "2100 is not a leap year");
+
 
 long operator-(const Date& d1, const Date& d2);
 
 inline double time_frac(const Date& d1, const Date& d2) {
     return static_cast<double>(d2 - d1) / 365.0;
 }
-}
\ No newline at end of file
+}
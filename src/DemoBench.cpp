@@ -0,0 +1,563 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <new>
+#include <sstream>
+#include <filesystem>
+#include <unistd.h>
+
+#include "Macros.h"
+#include "MarketDataServer.h"
+#include "PortfolioUtils.h"
+#include "FixingDataServer.h"
+#include "CurveDiscount.h"
+#include "PerfCounters.h"
+#include "TaskScheduler.h"
+
+using namespace::minirisk;
+
+// Benchmark suite of the pricing and risk kernels. Each benchmark is timed as a phase of the
+// performance counters (see PerfCounters.h), so that it is also measured with the hardware
+// counters when they are enabled.
+
+// Allocation counting hook: replaces the global operator new of this program, so that each
+// benchmark also reports how many heap allocations it makes (arrays and the nothrow forms
+// are forwarded here by the standard library).
+// The deallocation functions call free on blocks obtained from the replaced operator new,
+// which gcc cannot see when it inlines them, hence the diagnostic being turned off here.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void* operator new(size_t n)
+{
+    perf::count(perf::heap_allocations);
+    if (void* p = std::malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+#pragma GCC diagnostic pop
+
+// keeps the optimizer from discarding results
+static volatile double g_sink;
+
+static void sink(const portfolio_values_t& values)
+{
+    g_sink = portfolio_total(values).first;
+}
+
+static void sink(const std::vector<std::pair<string, portfolio_values_t>>& values)
+{
+    double s = 0.0;
+    for (const auto& v : values)
+        s += portfolio_total(v.second).first;
+    g_sink = s;
+}
+
+// Stream buffer discarding the text written to it, keeping its size and a hash (FNV-1a), so
+// that the report benchmarks measure the formatting and can check that both writers agree
+struct hash_streambuf : std::streambuf
+{
+    hash_streambuf() { setp(m_buf, m_buf + sizeof(m_buf)); }
+
+    uint64_t hash = 14695981039346656037ull;
+    size_t size = 0;
+
+protected:
+    int_type overflow(int_type c) override
+    {
+        consume();
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    int sync() override
+    {
+        consume();
+        return 0;
+    }
+
+private:
+    void consume()
+    {
+        for (const char* p = pbase(); p < pptr(); ++p)
+            hash = (hash ^ static_cast<unsigned char>(*p)) * 1099511628211ull;
+        size += pptr() - pbase();
+        setp(m_buf, m_buf + sizeof(m_buf));
+    }
+
+    char m_buf[1 << 16];
+};
+
+// print_price_vector as written before ReportWriter: one value at a time through the stream
+static void print_price_vector_iostream(const string& name, const portfolio_values_t& values, std::ostream& os)
+{
+    auto total_result = portfolio_total(values);
+    os
+        << "========================\n"
+        << name << ":\n"
+        << "========================\n"
+        << "Total:  " << total_result.first << "\n";
+    if (!total_result.second.empty())
+        os << "Errors: " << total_result.second.size() << "\n";
+    os << "\n========================\n";
+    for (size_t i = 0, n = values.size(); i < n; ++i) {
+        os << std::setw(5) << i << ": ";
+        if (std::isnan(values[i].first))
+            os << values[i].second;
+        else
+            os << values[i].first;
+        os << "\n";
+    }
+    os << "========================\n\n";
+}
+
+// Date conversions as written before the closed-form ones: a table of the first day of each
+// year, scanned linearly, and a loop over the months
+namespace old_date {
+
+static const unsigned days_in_month[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+static const unsigned days_ytd[12] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+
+static const std::vector<unsigned>& days_epoch()
+{
+    static const std::vector<unsigned> days = [] {
+        std::vector<unsigned> v(Date::N_YEARS);
+        for (unsigned i = 0, cumulative_days = 0; i < Date::N_YEARS; ++i) {
+            v[i] = cumulative_days;
+            cumulative_days += Date::is_leap_year(Date::FIRST_YEAR + i) ? 366 : 365;
+        }
+        return v;
+    }();
+    return days;
+}
+
+static void serial_to_calendar(unsigned serial, unsigned& year, unsigned& month, unsigned& day)
+{
+    const std::vector<unsigned>& epoch = days_epoch();
+    unsigned year_index = 0;
+    for (unsigned i = 0; i < Date::N_YEARS; ++i) {
+        if (epoch[i] > serial) {
+            year_index = i - 1;
+            break;
+        }
+        year_index = i;
+    }
+    year = Date::FIRST_YEAR + year_index;
+    unsigned remaining_days = serial - epoch[year_index];
+    month = 1;
+    for (unsigned m = 0; m < 12; ++m) {
+        unsigned n = (m == 1 && Date::is_leap_year(year)) ? 29 : days_in_month[m];
+        if (remaining_days < n) {
+            month = m + 1;
+            break;
+        }
+        remaining_days -= n;
+    }
+    day = remaining_days + 1;
+}
+
+static unsigned calendar_to_serial(unsigned year, unsigned month, unsigned day)
+{
+    return days_epoch()[year - Date::FIRST_YEAR] + days_ytd[month - 1]
+        + ((month > 2 && Date::is_leap_year(year)) ? 1 : 0) + (day - 1);
+}
+
+static string to_string(unsigned serial)
+{
+    unsigned year, month, day;
+    serial_to_calendar(serial, year, month, day);
+    std::ostringstream os;
+    os << year << std::setw(2) << std::setfill('0') << month << std::setw(2) << std::setfill('0') << day;
+    return os.str();
+}
+
+static unsigned parse(const string& s)
+{
+    unsigned y = std::atoi(s.substr(0, 4).c_str());
+    unsigned m = std::atoi(s.substr(4, 2).c_str());
+    unsigned d = std::atoi(s.substr(6, 2).c_str());
+    Date::check_valid(y, m, d);
+    return calendar_to_serial(y, m, d);
+}
+
+} // namespace old_date
+
+// every date from FIRST_YEAR to LAST_YEAR, converted both ways, formatted and parsed with
+// the old and the current implementation, which must agree
+static void bench_dates(unsigned repeats)
+{
+    const unsigned n = Date::calendar_to_serial(Date::LAST_YEAR, 1, 1);
+    std::vector<string> text(n);
+    for (unsigned s = 0; s < n; ++s)
+        text[s] = old_date::to_string(s);
+
+    for (unsigned r = 0; r < repeats; ++r) {
+        perf::ScopedPhase phase("date_roundtrip_old");
+        unsigned errors = 0;
+        for (unsigned s = 0; s < n; ++s) {
+            unsigned y, m, d;
+            old_date::serial_to_calendar(s, y, m, d);
+            errors += old_date::calendar_to_serial(y, m, d) != s;
+        }
+        MYASSERT(errors == 0, "Old date conversions do not round trip");
+    }
+    for (unsigned r = 0; r < repeats; ++r) {
+        perf::ScopedPhase phase("date_roundtrip");
+        unsigned errors = 0;
+        for (unsigned s = 0; s < n; ++s) {
+            unsigned y, m, d;
+            Date(s).serial_to_calendar(y, m, d);
+            errors += Date::calendar_to_serial(y, m, d) != s;
+        }
+        MYASSERT(errors == 0, "Date conversions do not round trip");
+    }
+    for (unsigned r = 0; r < repeats; ++r) {
+        perf::ScopedPhase phase("date_format_old");
+        for (unsigned s = 0; s < n; ++s)
+            MYASSERT(old_date::to_string(s) == text[s], "Old date formatting differs for serial " << s);
+    }
+    for (unsigned r = 0; r < repeats; ++r) {
+        perf::ScopedPhase phase("date_format");
+        for (unsigned s = 0; s < n; ++s) {
+            char buf[Date::YYYYMMDD_SIZE];
+            Date(s).format_yyyymmdd(buf);
+            MYASSERT(text[s].compare(0, string::npos, buf, sizeof(buf)) == 0, "Date formatting differs for serial " << s << ": " << text[s]);
+        }
+    }
+    for (unsigned r = 0; r < repeats; ++r) {
+        perf::ScopedPhase phase("date_parse_old");
+        for (unsigned s = 0; s < n; ++s)
+            MYASSERT(old_date::parse(text[s]) == s, "Old date parsing differs for " << text[s]);
+    }
+    for (unsigned r = 0; r < repeats; ++r) {
+        perf::ScopedPhase phase("date_parse");
+        for (unsigned s = 0; s < n; ++s) {
+            unsigned y, m, d;
+            MYASSERT(Date::parse_yyyymmdd(text[s].data(), y, m, d), "Not a date: " << text[s]);
+            MYASSERT(Date(y, m, d).serial() == s, "Date parsing differs for " << text[s]);
+        }
+    }
+}
+
+static void print_results()
+{
+    std::cout
+        << std::left << std::setw(24) << "benchmark" << std::right
+        << std::setw(8) << "calls" << std::setw(12) << "ms/call" << std::setw(12) << "trades/call" << std::setw(12) << "allocs/call"
+        << std::setw(8) << "ipc" << std::setw(14) << "llc_miss/trd" << std::setw(14) << "br_miss/trd" << "\n";
+    std::cout << std::fixed;
+    for (const auto& p : perf::phases()) {
+        std::cout
+            << std::left << std::setw(24) << p.name << std::right
+            << std::setw(8) << p.calls
+            << std::setw(12) << std::setprecision(4) << p.wall * 1e3 / static_cast<double>(p.calls)
+            << std::setw(12) << p.trades / p.calls
+            << std::setw(12) << p.allocations / p.calls;
+        if (p.hw) {
+            const int64_t* c = p.hw_counts;
+            auto per_trade = [&p](int64_t n) { return (n < 0 || p.trades == 0) ? -1.0 : static_cast<double>(n) / static_cast<double>(p.trades); };
+            std::cout << std::setprecision(2)
+                << std::setw(8) << (c[perf::hw_cycles] > 0 ? static_cast<double>(c[perf::hw_instructions]) / static_cast<double>(c[perf::hw_cycles]) : -1.0)
+                << std::setw(14) << per_trade(c[perf::hw_llc_misses])
+                << std::setw(14) << per_trade(c[perf::hw_branch_misses]);
+        }
+        std::cout << "\n";
+    }
+}
+
+// Check that the parallel loader gives the same trades, or the same error, as the serial one
+static void check_loaders(const string& filename)
+{
+    auto load = [&filename](std::vector<ptrade_t> (*loader)(const string&)) {
+        std::ostringstream os;
+        try {
+            print_portfolio(loader(filename), os);
+        } catch (const std::exception& e) {
+            os << "Error: " << e.what();
+        }
+        return os.str();
+    };
+    const string serial = load(load_portfolio);
+    const string parallel = load(load_portfolio_parallel);
+    MYASSERT(serial == parallel, "Serial and parallel loaders differ on " << filename
+        << "\nserial:   " << serial.substr(0, 200) << "\nparallel: " << parallel.substr(0, 200));
+}
+
+// Same check on the portfolio and on files with edge cases of the line format
+static void check_loaders_all(const string& portfolio_file)
+{
+    check_loaders(portfolio_file);
+
+    const char* const edge_cases[] = {
+        "0;10;USD;20200201\n0;20;EUR;20200202;\n",    // line without a final separator
+        "0;10;USD;20200201;\n0;20;EUR;20200202;",      // file without a final new line
+    };
+    const string prefix = (std::filesystem::temp_directory_path() / ("minirisk." + std::to_string(::getpid()) + ".loader")).string();
+    for (size_t i = 0; i < sizeof(edge_cases) / sizeof(edge_cases[0]); ++i) {
+        const string fn = prefix + std::to_string(i) + ".txt";
+        {
+            std::ofstream of(fn, std::ios::binary);
+            of << edge_cases[i];
+        }
+        try {
+            check_loaders(fn);
+        } catch (...) {
+            std::remove(fn.c_str());
+            throw;
+        }
+        std::remove(fn.c_str());
+    }
+}
+
+void run(const string& portfolio_file, const string& risk_factors_file, const string& base_ccy, const string& fixings_file, unsigned repeats, unsigned report_scale)
+{
+    check_loaders_all(portfolio_file);
+
+    portfolio_t portfolio;
+    for (unsigned r = 0; r < repeats; ++r) {
+        perf::ScopedPhase phase("load_portfolio");
+        portfolio = load_portfolio(portfolio_file);
+    }
+    for (unsigned r = 0; r < repeats; ++r) {
+        perf::ScopedPhase phase("load_portfolio_parallel");
+        portfolio = load_portfolio_parallel(portfolio_file);
+    }
+    std::vector<ppricer_t> pricers(get_pricers(portfolio, base_ccy));
+
+    std::shared_ptr<const MarketDataServer> mds(new MarketDataServer(risk_factors_file));
+    std::unique_ptr<FixingDataServer> fds;
+    if (!fixings_file.empty())
+        fds.reset(new FixingDataServer(fixings_file));
+
+    Date today(2017,8,5);
+
+    // pricing with a fresh market, including the construction of all curves
+    for (unsigned r = 0; r < repeats; ++r) {
+        Market mkt(mds, today);
+        perf::ScopedPhase phase("compute_prices_cold");
+        sink(compute_prices(pricers, mkt, fds.get()));
+    }
+
+    // pricing with all curves already built
+    Market mkt(mds, today);
+    sink(compute_prices(pricers, mkt, fds.get()));
+    for (unsigned r = 0; r < repeats; ++r) {
+        perf::ScopedPhase phase("compute_prices_warm");
+        sink(compute_prices(pricers, mkt, fds.get()));
+    }
+
+    // discount factor kernel: every discount curve over daily dates, up to one year or the
+    // last tenor of the curve
+    {
+        std::vector<ptr_disc_curve_t> curves;
+        for (const auto& rf : mds->match("IR\\.[0-9]+[DWMY]\\.[A-Z]{3}")) {
+            string name = ir_curve_discount_name(Ccy(rf.substr(rf.size() - 3)));
+            if (curves.empty() || curves.back()->name() != name)
+                curves.push_back(mkt.get_discount_curve(name));
+        }
+        for (unsigned r = 0; r < repeats; ++r) {
+            perf::ScopedPhase phase("curve_df");
+            double s = 0.0;
+            for (const auto& c : curves) {
+                try {
+                    for (unsigned d = 0; d < 365; ++d)
+                        s += c->df(Date(today.serial() + d));
+                } catch (const std::exception&) {
+                }
+            }
+            g_sink = s;
+        }
+    }
+
+    // sensitivities, with all risk factors loaded as in DemoRisk
+    for (const auto& rf : mds->match(".+"))
+        mkt.get_value(rf, "risk factor");
+    for (unsigned r = 0; r < repeats; ++r) {
+        perf::ScopedPhase phase("pv01_bucketed");
+        sink(compute_pv01_bucketed(pricers, mkt, fds.get()));
+    }
+    for (unsigned r = 0; r < repeats; ++r) {
+        perf::ScopedPhase phase("pv01_parallel");
+        sink(compute_pv01_parallel(pricers, mkt, fds.get()));
+    }
+    for (unsigned r = 0; r < repeats; ++r) {
+        perf::ScopedPhase phase("fx_delta");
+        sink(compute_fx_delta(pricers, mkt, fds.get()));
+    }
+
+    bench_dates(repeats);
+
+    // text reports: the PV and sensitivity sections of DemoRisk, printed report_scale times
+    // through the stream one value at a time, then with ReportWriter
+    std::vector<std::pair<string, portfolio_values_t>> report;
+    report.emplace_back("PV", compute_prices(pricers, mkt, fds.get()));
+    for (auto& g : compute_pv01_bucketed(pricers, mkt, fds.get()))
+        report.emplace_back("PV01 bucketed " + g.first, std::move(g.second));
+    for (auto& g : compute_pv01_parallel(pricers, mkt, fds.get()))
+        report.emplace_back("PV01 parallel " + g.first, std::move(g.second));
+    for (auto& g : compute_fx_delta(pricers, mkt, fds.get()))
+        report.emplace_back("FX delta " + g.first, std::move(g.second));
+    hash_streambuf old_buf, new_buf;
+    if (report_scale > 0) {
+        std::ostream os(&old_buf);
+        perf::ScopedPhase phase("report_iostream");
+        for (unsigned r = 0; r < report_scale; ++r)
+            for (const auto& g : report)
+                print_price_vector_iostream(g.first, g.second, os);
+        os.flush();
+    }
+    if (report_scale > 0) {
+        std::ostream os(&new_buf);
+        perf::ScopedPhase phase("report_writer");
+        for (unsigned r = 0; r < report_scale; ++r)
+            for (const auto& g : report)
+                print_price_vector(g.first, g.second, os);
+        os.flush();
+    }
+    MYASSERT(old_buf.size == new_buf.size && old_buf.hash == new_buf.hash, "Report writers disagree");
+
+    print_results();
+
+    if (report_scale > 0) {
+        std::cout << "\nreport: " << report_scale << " x " << report.size() << " sections, " << new_buf.size / 1e6 << " MB";
+        for (const auto& p : perf::phases())
+            if (p.name == "report_iostream" || p.name == "report_writer")
+                std::cout << ", " << p.name << " " << new_buf.size / 1e6 / p.wall << " MB/s";
+        std::cout << "\n";
+    }
+
+    std::cout << "\nlatency (us): name;count;p50;p99;p99.9;max\n";
+    perf::print_latency(std::cout);
+}
+
+void usage(const char* program_name)
+{
+    std::cerr
+        << "Usage: " << program_name << " -p <portfolio_file> -f <risk_factors_file> [-b <base_currency>] [-x <fixings_file>] [-n <repeats>] [-R <report_scale>] [-j <threads>] [-A 0] [-H 1] [-s <stats_file>]\n"
+        << "\n"
+        << "Times the pricing and risk kernels and prints one line per benchmark.\n"
+        << "\n"
+        << "Required arguments:\n"
+        << "  -p <portfolio_file>        Path to the portfolio file\n"
+        << "  -f <risk_factors_file>     Path to the risk factors file\n"
+        << "\n"
+        << "Optional arguments:\n"
+        << "  -b <base_currency>         Base currency (default: USD)\n"
+        << "  -x <fixings_file>          Path to the fixings file (optional)\n"
+        << "  -n <repeats>               Number of runs of each benchmark (default: 10)\n"
+        << "  -R <report_scale>          Number of copies of the report in the text output\n"
+        << "                             benchmarks (default: 1000, 0 to skip them)\n"
+        << "  -j <threads>               Threads pricing the portfolio and the bump scenarios\n"
+        << "                             (default: hardware concurrency)\n"
+        << "  -A 0                       Build the bumped curves on the heap instead of in scenario arenas\n"
+        << "  -H 1                       Sample hardware counters: IPC, LLC and branch misses per trade\n"
+        << "  -s <stats_file>            Also write the results and all counters as JSON\n"
+        << "\n"
+        << "Example:\n"
+        << "  " << program_name << " -p data/portfolio_10.txt -f data/risk_factors_3.txt -x data/fixings.txt -H 1\n";
+    std::exit(1);
+}
+
+int main(int argc, const char **argv)
+{
+    // Handle no arguments case
+    if (argc == 1) {
+        usage(argv[0]);
+    }
+
+    string portfolio, riskfactors, fixings_file, stats_file;
+    string base_ccy = "USD";
+    unsigned repeats = 10;
+    unsigned report_scale = 1000;
+
+    // Validate argument count (must be odd: program name + pairs of key-value)
+    if (argc % 2 == 0) {
+        std::cerr << "Error: Invalid number of arguments.\n\n";
+        usage(argv[0]);
+    }
+
+    for (int i = 1; i < argc; i += 2) {
+        string key(argv[i]);
+        string value(argv[i+1]);
+
+        if (value.empty()) {
+            std::cerr << "Error: Empty value provided for argument: " << key << "\n\n";
+            usage(argv[0]);
+        }
+
+        if (key == "-p") {
+            portfolio = value;
+        } else if (key == "-f") {
+            riskfactors = value;
+        } else if (key == "-b") {
+            base_ccy = value;
+        } else if (key == "-x") {
+            fixings_file = value;
+        } else if (key == "-n") {
+            repeats = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "-R") {
+            report_scale = std::max(0, std::atoi(value.c_str()));
+        } else if (key == "-j") {
+            TaskScheduler::set_global_threads(std::max(1, std::atoi(value.c_str())));
+        } else if (key == "-A") {
+            Market::enable_arenas(value != "0");
+        } else if (key == "-H") {
+            perf::enable_hw(value != "0");
+        } else if (key == "-s") {
+            stats_file = value;
+        } else {
+            std::cerr << "Error: Unknown argument: " << key << "\n\n";
+            usage(argv[0]);
+        }
+    }
+
+    if (portfolio.empty() || riskfactors.empty()) {
+        std::cerr << "Error: Missing required arguments.\n\n";
+        usage(argv[0]);
+    }
+
+    perf::enable();
+    perf::enable_latency();
+    if (perf::hw_enabled() && !perf::this_thread_hw_counters().status().empty())
+        std::cerr << "Hardware counters: " << perf::this_thread_hw_counters().status() << "\n";
+
+    try {
+        run(portfolio, riskfactors, base_ccy, fixings_file, repeats, report_scale);
+        if (!stats_file.empty()) {
+            std::ofstream os(stats_file);
+            MYASSERT(!os.fail(), "Could not open file " << stats_file);
+            perf::write_json(os);
+        }
+        return 0;  // report success to the caller
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return -1; // report an error to the caller
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown exception occurred\n";
+        return -1; // report an error to the caller
+    }
+}
+
+// Under src folder: make
+// src/bin/DemoBench.exe -p data/portfolio_10.txt -f data/risk_factors_3.txt -x data/fixings.txt -H 1
+// src/bin/DemoBench.exe -p data/portfolio_10.txt -f data/risk_factors_3.txt -x data/fixings.txt -n 50 -s bench_10.json
+// src/bin/DemoBench.exe -p data/portfolio_10.txt -f data/risk_factors_3.txt -x data/fixings.txt -A 0
@@ -0,0 +1,66 @@
+#include <iostream>
+
+#include "Macros.h"
+#include "LocalSocket.h"
+
+using namespace::minirisk;
+
+// send one request and print the reply; returns false if the server reported an error
+static bool request(LocalSocket& s, const string& req)
+{
+    s.write(req + "\n");
+
+    string status;
+    MYASSERT(s.read_line(status), "Connection closed by the server");
+    bool ok = status.compare(0, 2, "OK") == 0;
+    if (!ok)
+        std::cerr << status << "\n";
+
+    // result lines, terminated by an empty line
+    for (string line; s.read_line(line) && !line.empty();)
+        std::cout << line << "\n";
+    return ok;
+}
+
+void usage(const char* program_name)
+{
+    std::cerr
+        << "Usage: " << program_name << " -s <socket_path> [request ...]\n"
+        << "\n"
+        << "Sends the request given on the command line to a running DemoServer, or one\n"
+        << "request per line read from stdin if none is given, and prints the replies.\n"
+        << "\n"
+        << "Examples:\n"
+        << "  " << program_name << " -s /tmp/minirisk.sock PV\n"
+        << "  " << program_name << " -s /tmp/minirisk.sock ADD \"0;20;EUR;42949;\"\n"
+        << "  " << program_name << " -s /tmp/minirisk.sock SET IR.1Y.EUR 0.03\n";
+    std::exit(1);
+}
+
+int main(int argc, const char **argv)
+{
+    if (argc < 3 || string(argv[1]) != "-s") {
+        usage(argv[0]);
+    }
+
+    try {
+        LocalSocket s = LocalSocket::connect(argv[2]);
+        bool ok = true;
+        if (argc > 3) {
+            string req(argv[3]);
+            for (int i = 4; i < argc; ++i)
+                req += string(" ") + argv[i];
+            ok = request(s, req);
+        } else {
+            for (string req; std::getline(std::cin, req);)
+                if (!req.empty())
+                    ok = request(s, req) && ok;
+        }
+        return ok ? 0 : -1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return -1; // report an error to the caller
+    }
+}
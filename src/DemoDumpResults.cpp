@@ -0,0 +1,98 @@
+#include <iostream>
+#include <cstdlib>
+
+#include "Macros.h"
+#include "ResultCube.h"
+
+using namespace::minirisk;
+
+void run(const string& results_file, const string& column)
+{
+    ResultCube cube(results_file);
+
+    bool found = false;
+    for (size_t c = 0; c < cube.n_columns(); ++c) {
+        if (!column.empty() && cube.name(c) != column)
+            continue;
+        print_result_column(cube, c);
+        found = true;
+    }
+    MYASSERT(found || column.empty(), "Column not found: " << column);
+}
+
+void usage(const char* program_name)
+{
+    std::cerr
+        << "Usage: " << program_name << " -i <results_file> [-c <column>]\n"
+        << "\n"
+        << "Prints a binary results file written by DemoRisk -r in the text format of the reports.\n"
+        << "\n"
+        << "Required arguments:\n"
+        << "  -i <results_file>          Path to the binary results file\n"
+        << "\n"
+        << "Optional arguments:\n"
+        << "  -c <column>                Print only this column (e.g. \"PV01 parallel IR.USD\")\n"
+        << "\n"
+        << "Example:\n"
+        << "  " << program_name << " -i results_10_USD.bin\n";
+    std::exit(1);
+}
+
+int main(int argc, const char **argv)
+{
+    // Handle no arguments case
+    if (argc == 1) {
+        usage(argv[0]);
+    }
+
+    string results_file, column;
+
+    // Validate argument count (must be odd: program name + pairs of key-value)
+    if (argc % 2 == 0) {
+        std::cerr << "Error: Invalid number of arguments.\n\n";
+        usage(argv[0]);
+    }
+
+    for (int i = 1; i < argc; i += 2) {
+        string key(argv[i]);
+        string value(argv[i+1]);
+
+        if (value.empty()) {
+            std::cerr << "Error: Empty value provided for argument: " << key << "\n\n";
+            usage(argv[0]);
+        }
+
+        if (key == "-i") {
+            results_file = value;
+        } else if (key == "-c") {
+            column = value;
+        } else {
+            std::cerr << "Error: Unknown argument: " << key << "\n\n";
+            usage(argv[0]);
+        }
+    }
+
+    if (results_file.empty()) {
+        std::cerr << "Error: Missing required arguments.\n\n";
+        usage(argv[0]);
+    }
+
+    try {
+        run(results_file, column);
+        return 0;  // report success to the caller
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return -1; // report an error to the caller
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown exception occurred\n";
+        return -1; // report an error to the caller
+    }
+}
+
+// Under src folder: make
+// src/bin/DemoRisk.exe -p data/portfolio_10.txt -f data/risk_factors_3.txt -x data/fixings.txt -r results_10
+// src/bin/DemoDumpResults.exe -i results_10_USD.bin
@@ -0,0 +1,202 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cstdlib>
+
+#include "Macros.h"
+#include "Exposure.h"
+#include "MarketDataServer.h"
+#include "FixingDataServer.h"
+#include "TaskScheduler.h"
+
+using namespace::minirisk;
+
+// Helper function to check if file exists
+static bool file_exists(const string& filename)
+{
+    std::ifstream file(filename);
+    return file.good();
+}
+
+// Netting set of each trade, from lines "trade_index;netting_set". Trades not listed are in
+// the netting set UNASSIGNED.
+static std::vector<string> load_netting_sets(const string& filename, size_t n_trades)
+{
+    std::ifstream is(filename);
+    MYASSERT(!is.fail(), "Could not open file " << filename);
+    std::vector<string> netting_sets(n_trades, "UNASSIGNED");
+    string line;
+    for (size_t n = 1; std::getline(is, line); ++n) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty())
+            continue;
+        const size_t sep = line.find(';');
+        MYASSERT(sep != string::npos && sep > 0 && sep + 1 < line.size(), "Invalid netting set line " << n << " in " << filename << ": " << line);
+        char* end;
+        const unsigned long i = std::strtoul(line.c_str(), &end, 10);
+        MYASSERT(end == line.c_str() + sep, "Invalid trade index on line " << n << " in " << filename << ": " << line);
+        MYASSERT(i < n_trades, "Trade index " << i << " on line " << n << " in " << filename << " is beyond the " << n_trades << " trades of the portfolio");
+        netting_sets[i] = line.substr(sep + 1);
+    }
+    return netting_sets;
+}
+
+void run(const string& portfolio_file, const string& risk_factors_file, const string& base_ccy, const string& fixings_file
+    , const string& netting_file, const string& output_file, const exposure_settings_t& settings)
+{
+    MYASSERT(file_exists(portfolio_file), "Portfolio file does not exist: " << portfolio_file);
+    MYASSERT(file_exists(risk_factors_file), "Risk factors file does not exist: " << risk_factors_file);
+    if (!fixings_file.empty()) {
+        MYASSERT(file_exists(fixings_file), "Fixings file does not exist: " << fixings_file);
+    }
+    MYASSERT(base_ccy.length() == 3, "Base currency must be 3 characters (ISO 4217 code), got: " << base_ccy);
+
+    portfolio_t portfolio = load_portfolio(portfolio_file);
+    std::vector<string> netting_sets;
+    if (!netting_file.empty())
+        netting_sets = load_netting_sets(netting_file, portfolio.size());
+
+    std::unique_ptr<FixingDataServer> fds;
+    if (!fixings_file.empty())
+        fds.reset(new FixingDataServer(fixings_file));
+
+    std::shared_ptr<const MarketDataServer> mds(new MarketDataServer(risk_factors_file));
+    Date today(2017,8,5);
+    Market mkt(mds, today);
+
+    exposure_result_t res = simulate_exposure(portfolio, mkt, fds.get(), base_ccy, netting_sets, settings);
+
+    std::cerr << "Paths: " << res.paths << ", dates: " << res.dates.size()
+        << ", trades: " << res.trades << ", skipped: " << res.skipped << ", errors: " << res.errors.size() << "\n";
+    for (const auto& e : res.errors)
+        std::cerr << "  trade " << e.first << ": " << e.second << "\n";
+    std::cerr << "Simulation: " << std::fixed << std::setprecision(3) << res.seconds << "s, "
+        << std::setprecision(0) << res.path_dates_per_second() << " path-dates/s\n" << std::defaultfloat;
+
+    std::ofstream of;
+    if (!output_file.empty()) {
+        of.open(output_file);
+        MYASSERT(!of.fail(), "Could not open file " << output_file);
+    }
+    std::ostream& os = output_file.empty() ? std::cout : of;
+    os << std::setprecision(10);
+    for (const auto& prof : res.profiles) {
+        os << "Netting set " << prof.netting_set << " (" << base_ccy << "): date;EPE;PFE;mean\n";
+        for (size_t k = 0; k < res.dates.size(); ++k)
+            os << res.dates[k] << ";" << prof.epe[k] << ";" << prof.pfe[k] << ";" << prof.mean[k] << "\n";
+    }
+}
+
+void usage(const char* program_name)
+{
+    std::cerr
+        << "Usage: " << program_name << " -p <portfolio_file> -f <risk_factors_file> [-b <base_currency>] [-x <fixings_file>] [-n <paths>] [-g <step_days>] [-v <fx_vol>] [-q <quantile>] [-s <seed>] [-N <netting_file>] [-j <threads>] [-o <output_file>]\n"
+        << "\n"
+        << "Simulates the exposure of the FX forwards of a portfolio by Monte Carlo, with FX\n"
+        << "spots lognormal around their forwards and deterministic rates, and prints for each\n"
+        << "netting set and simulation date the expected positive exposure (EPE), the potential\n"
+        << "future exposure (PFE) and the expected value. Other trades are skipped. The results\n"
+        << "only depend on the seed, not on the number of threads.\n"
+        << "\n"
+        << "Required arguments:\n"
+        << "  -p <portfolio_file>        Path to the portfolio file\n"
+        << "  -f <risk_factors_file>     Path to the risk factors file\n"
+        << "\n"
+        << "Optional arguments:\n"
+        << "  -b <base_currency>         Base currency (default: USD)\n"
+        << "  -x <fixings_file>          Path to the fixings file (optional)\n"
+        << "  -n <paths>                 Number of paths (default: 10000)\n"
+        << "  -g <step_days>             Days between simulation dates (default: 30)\n"
+        << "  -v <fx_vol>                Volatility of the FX spots (default: 0.10)\n"
+        << "  -q <quantile>              Quantile of the PFE (default: 0.975)\n"
+        << "  -s <seed>                  Seed of the random numbers (default: 1)\n"
+        << "  -N <netting_file>          Netting sets, as lines trade_index;netting_set (default:\n"
+        << "                             one netting set ALL; trades not listed are UNASSIGNED)\n"
+        << "  -j <threads>               Number of threads (default: hardware concurrency)\n"
+        << "  -o <output_file>           Write the results to this file instead of stdout\n"
+        << "\n"
+        << "Example:\n"
+        << "  " << program_name << " -p data/portfolio_10.txt -f data/risk_factors_3.txt -x data/fixings.txt -n 20000\n";
+    std::exit(1);
+}
+
+int main(int argc, const char **argv)
+{
+    // Handle no arguments case
+    if (argc == 1) {
+        usage(argv[0]);
+    }
+
+    string portfolio, riskfactors, output, fixings_file, netting_file;
+    string base_ccy = "USD";
+    exposure_settings_t settings;
+
+    // Validate argument count (must be odd: program name + pairs of key-value)
+    if (argc % 2 == 0) {
+        std::cerr << "Error: Invalid number of arguments.\n\n";
+        usage(argv[0]);
+    }
+
+    for (int i = 1; i < argc; i += 2) {
+        string key(argv[i]);
+        string value(argv[i+1]);
+
+        if (value.empty()) {
+            std::cerr << "Error: Empty value provided for argument: " << key << "\n\n";
+            usage(argv[0]);
+        }
+
+        if (key == "-p") {
+            portfolio = value;
+        } else if (key == "-f") {
+            riskfactors = value;
+        } else if (key == "-o") {
+            output = value;
+        } else if (key == "-b") {
+            base_ccy = value;
+        } else if (key == "-x") {
+            fixings_file = value;
+        } else if (key == "-N") {
+            netting_file = value;
+        } else if (key == "-n") {
+            settings.n_paths = static_cast<size_t>(std::max(1L, std::atol(value.c_str())));
+        } else if (key == "-g") {
+            settings.step_days = static_cast<unsigned>(std::max(1, std::atoi(value.c_str())));
+        } else if (key == "-v") {
+            settings.fx_vol = std::atof(value.c_str());
+        } else if (key == "-q") {
+            settings.pfe_quantile = std::atof(value.c_str());
+        } else if (key == "-s") {
+            settings.seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "-j") {
+            TaskScheduler::set_global_threads(static_cast<unsigned>(std::max(0, std::atoi(value.c_str()))));
+        } else {
+            std::cerr << "Error: Unknown argument: " << key << "\n\n";
+            usage(argv[0]);
+        }
+    }
+
+    if (portfolio.empty() || riskfactors.empty()) {
+        std::cerr << "Error: Missing required arguments.\n\n";
+        usage(argv[0]);
+    }
+
+    try {
+        run(portfolio, riskfactors, base_ccy, fixings_file, netting_file, output, settings);
+        return 0;  // report success to the caller
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return -1; // report an error to the caller
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown exception occurred\n";
+        return -1; // report an error to the caller
+    }
+}
+
+// Under src folder: make
+// src/bin/DemoExposure.exe -p data/portfolio_10.txt -f data/risk_factors_3.txt -x data/fixings.txt -n 20000
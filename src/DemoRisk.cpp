@@ -2,12 +2,19 @@
 #include <algorithm>
 #include <set>
 #include <fstream>
+#include <sstream>
+#include <future>
+#include <cmath>
 
 #include "Macros.h"
 #include "MarketDataServer.h"
 #include "PortfolioUtils.h"
+#include "SensitivityMatrix.h"
+#include "ResultCube.h"
 #include "FixingDataServer.h"
-#include "TradePayment.h"
+#include "PerfCounters.h"
+#include "Trace.h"
+#include "TaskScheduler.h"
 
 using namespace::minirisk;
 
@@ -18,7 +25,42 @@ static bool file_exists(const string& filename)
     return file.good();
 }
 
-void run(const string& portfolio_file, const string& risk_factors_file, const string& base_ccy, const string& fixings_file)
+// How PV01 parallel is computed
+enum pv01_parallel_mode_t
+{
+    parallel_full,          // reprice with all tenors of a currency bumped together
+    parallel_bucketed,      // sum of the PV01 bucketed (exact for products linear in the curve)
+    parallel_check,         // both, reporting the repriced ones and the trades where they differ
+};
+
+// Report on stderr the trades whose PV01 parallel derived from the bucketed ones differs from
+// the repriced one by more than a relative tolerance (or which are in error in only one)
+static void check_pv01_parallel(const SensitivityMatrix& full, const SensitivityMatrix& derived, const string& base_ccy)
+{
+    const double tolerance = 1e-6;
+    MYASSERT(full.n_factors() == derived.n_factors(), "PV01 parallel has " << full.n_factors() << " currencies, " << derived.n_factors() << " from PV01 bucketed");
+    for (size_t f = 0; f < full.n_factors(); ++f) {
+        const portfolio_values_t a = full.dense(f);
+        const portfolio_values_t b = derived.dense(f);
+        size_t mismatches = 0;
+        double max_diff = 0.0;
+        for (size_t i = 0; i < a.size(); ++i) {
+            const bool nan_a = std::isnan(a[i].first), nan_b = std::isnan(b[i].first);
+            const double diff = (nan_a || nan_b) ? 0.0 : std::abs(a[i].first - b[i].first);
+            if (nan_a != nan_b || diff > tolerance * std::max(1.0, std::abs(a[i].first))) {
+                if (mismatches++ < 5)
+                    std::cerr << "PV01 parallel " << full.factor(f) << " (" << base_ccy << ") trade " << i << ": "
+                        << (nan_a ? a[i].second : std::to_string(a[i].first)) << " repriced, "
+                        << (nan_b ? b[i].second : std::to_string(b[i].first)) << " from PV01 bucketed\n";
+            }
+            max_diff = std::max(max_diff, diff);
+        }
+        std::cerr << "PV01 parallel " << full.factor(f) << " (" << base_ccy << "): " << mismatches
+            << " trades differ from PV01 bucketed, max difference " << max_diff << "\n";
+    }
+}
+
+void run(const string& portfolio_file, const string& risk_factors_file, const std::vector<string>& base_ccys, const string& fixings_file, const string& output_prefix, bool sparse, const string& results_prefix, const bump_settings_t& bumps, pv01_parallel_mode_t parallel_mode)
 {
     // Validate file existence
     MYASSERT(file_exists(portfolio_file), "Portfolio file does not exist: " << portfolio_file);
@@ -27,157 +69,248 @@ void run(const string& portfolio_file, const string& risk_factors_file, const st
         MYASSERT(file_exists(fixings_file), "Fixings file does not exist: " << fixings_file);
     }
     
-    // Validate base currency is not empty
-    MYASSERT(!base_ccy.empty(), "Base currency cannot be empty");
-    MYASSERT(base_ccy.length() == 3, "Base currency must be 3 characters (ISO 4217 code), got: " << base_ccy);
+    // Validate base currencies
+    MYASSERT(!base_ccys.empty(), "Base currency cannot be empty");
+    for (const auto& base_ccy : base_ccys) {
+        MYASSERT(!base_ccy.empty(), "Base currency cannot be empty");
+        MYASSERT(base_ccy.length() == 3, "Base currency must be 3 characters (ISO 4217 code), got: " << base_ccy);
+        MYASSERT(std::count(base_ccys.begin(), base_ccys.end(), base_ccy) == 1, "Duplicated base currency: " << base_ccy);
+    }
+
+    // With a single base currency the pricers convert to it directly. With several base
+    // currencies the portfolio is priced and bumped once in trade currency, and every
+    // scenario is converted into each base currency.
+    const bool multi = base_ccys.size() > 1;
+
+    // one report per base currency, written to stdout unless an output prefix is given
+    std::vector<std::unique_ptr<std::ofstream>> files;
+    std::vector<std::ostream*> outs;
+    for (const auto& base_ccy : base_ccys) {
+        if (output_prefix.empty()) {
+            outs.push_back(&std::cout);
+        } else {
+            string fn = output_prefix + "_" + base_ccy + ".txt";
+            files.emplace_back(new std::ofstream(fn));
+            MYASSERT(!files.back()->fail(), "Could not open file " << fn);
+            outs.push_back(files.back().get());
+        }
+    }
     
+    // Market data and fixings do not depend on the portfolio: they are loaded on their own
+    // threads while the portfolio is loaded, printed and bound to pricers on this one.
+    // Errors are rethrown when the results are first needed, so that they are reported in the
+    // same order as with a sequential startup.
+    auto mds_loading = std::async(std::launch::async, [&risk_factors_file]() {
+        trace::ScopedEvent event("load_market_data", "io", risk_factors_file);
+        perf::ScopedPhase phase("load_market_data");
+        return std::shared_ptr<const MarketDataServer>(new MarketDataServer(risk_factors_file));
+    });
+    auto fds_loading = std::async(std::launch::async, [&fixings_file]() {
+        std::unique_ptr<FixingDataServer> fds;
+        if (!fixings_file.empty()) {
+            trace::ScopedEvent event("load_fixings", "io", fixings_file);
+            perf::ScopedPhase phase("load_fixings");
+            fds.reset(new FixingDataServer(fixings_file));
+        }
+        return fds;
+    });
+
     // load the portfolio from file
-    portfolio_t portfolio = load_portfolio(portfolio_file);
+    portfolio_t portfolio;
+    {
+        perf::ScopedPhase phase("load_portfolio");
+        portfolio = load_portfolio_parallel(portfolio_file);
+    }
 
     // save and reload portfolio to implicitly test round trip serialization
-    save_portfolio("portfolio.tmp", portfolio);
-    portfolio.clear();
-    portfolio = load_portfolio("portfolio.tmp");
+    {
+        perf::ScopedPhase phase("portfolio_round_trip");
+        save_portfolio("portfolio.tmp", portfolio);
+        portfolio.clear();
+        portfolio = load_portfolio("portfolio.tmp");
+    }
 
     // display portfolio
-    print_portfolio(portfolio);
+    {
+        perf::ScopedPhase phase("print");
+        for (auto os : outs)
+            print_portfolio(portfolio, *os);
+    }
+
+    // get pricers configured with base currency, or in trade currency for multiple base currencies
+    std::vector<ppricer_t> pricers;
+    {
+        perf::ScopedPhase phase("get_pricers");
+        pricers = multi ? get_native_pricers(portfolio) : get_pricers(portfolio, base_ccys.front());
+    }
 
-    // get pricers configured with base currency
-    std::vector<ppricer_t> pricers(get_pricers(portfolio, base_ccy));
+    // optional binary results, one file per base currency, with the same columns as the reports
+    std::vector<std::unique_ptr<ResultCubeWriter>> cubes;
+    if (!results_prefix.empty())
+        for (const auto& base_ccy : base_ccys)
+            cubes.emplace_back(new ResultCubeWriter(results_prefix + "_" + base_ccy + ".bin", pricers.size()));
 
-    // initialize market data server
-    std::shared_ptr<const MarketDataServer> mds(new MarketDataServer(risk_factors_file));
+    // print a sensitivity in the report of base currency b, and add it to its binary results
+    auto report = [&](size_t b, const string& name, const SensitivityMatrix& m, size_t f) {
+        print_sensitivity(name, m, f, sparse, *outs[b]);
+        if (!cubes.empty())
+            cubes[b]->add(name, m, f);
+    };
 
-    // initialize fixing data server (optional)
+    // wait for the market data server and the fixing data server (optional)
+    std::shared_ptr<const MarketDataServer> mds;
     std::unique_ptr<FixingDataServer> fds;
-    if (!fixings_file.empty()) {
-        fds.reset(new FixingDataServer(fixings_file));
+    {
+        perf::ScopedPhase phase("wait_market_data");
+        mds = mds_loading.get();
+        fds = fds_loading.get();
     }
 
     // Init market object
     Date today(2017,8,5);
     Market mkt(mds, today);
 
-    // Price all products. Market objects are automatically constructed on demand,
-    // fetching data as needed from the market data server.
-    {
-        auto prices = compute_prices(pricers, mkt, fds.get());
-        print_price_vector("PV", prices);
-    }
-
-    // Preload all risk factors before any pricing calculations
-    // This ensures all risk factors are cached in the market object
+    // Price all products. Market objects are automatically constructed on demand, fetching
+    // data as needed from the market data server: the risk factors fetched are exactly those
+    // the pricers depend on, which are the only ones bumped below.
+    std::vector<std::set<string>> risk_factors;
     {
-        std::cout << "Risk factors:\n";
-        // Determine currencies involved
-        std::set<string> trade_ccys;
-        for (const auto& t : portfolio) {
-            const TradePayment* tp = dynamic_cast<const TradePayment*>(t.get());
-            if (tp) trade_ccys.insert(tp->ccy());
+        std::vector<portfolio_values_t> prices;
+        std::vector<std::vector<string>> required;
+        {
+            perf::ScopedPhase phase("compute_prices");
+            required = required_risk_factors(pricers, mkt, fds.get(), multi ? base_ccys : std::vector<string>(), &prices);
         }
-        std::set<string> fx_ccys = trade_ccys;
-        fx_ccys.insert(base_ccy);
-        // If cross conversion is needed for any trade (neither side is USD), include USD
-        bool needs_usd = (base_ccy != "USD");
-        if (needs_usd) {
-            for (const auto& c : trade_ccys) {
-                if (c != "USD" && c != base_ccy) { needs_usd = true; break; }
-                needs_usd = false;
-            }
+        perf::ScopedPhase phase("print");
+        for (size_t b = 0; b < outs.size(); ++b) {
+            print_price_vector("PV", prices[b], *outs[b]);
+            if (!cubes.empty())
+                cubes[b]->add("PV", prices[b]);
         }
-        if (needs_usd) fx_ccys.insert("USD");
-
-        // Load all risk factors from the market data server
-        auto all_risk_factors = mds->match(".+");
-        for (const auto& rf : all_risk_factors) {
-            // Access each risk factor to trigger loading into market cache
-            mkt.get_value(rf, "risk factor");
-            // FX spot risk factors for relevant currencies
-            if (rf.find(fx_spot_prefix) == 0) {
-                string ccy = rf.substr(fx_spot_prefix.size());
-                if (fx_ccys.count(ccy))
-                    std::cout << rf << "\n";
-                continue;
-            }
-            // IR tenor risk factors for portfolio currencies
-            if (rf.find(ir_rate_prefix) == 0) {
-                if (rf.size() >= 3) {
-                    string ccy = rf.substr(rf.size() - 3, 3);
-                    if (trade_ccys.count(ccy))
-                        std::cout << rf << "\n";
-                }
-            }
+
+        // risk factors each report depends on
+        for (size_t b = 0; b < outs.size(); ++b) {
+            const auto& rfs = required[multi ? b : 0];
+            std::ostream& os = *outs[b];
+            os << "Risk factors:\n";
+            for (const auto& rf : rfs)
+                os << rf << "\n";
+            os << "\n";
+            risk_factors.emplace_back(rfs.begin(), rfs.end());
         }
-        std::cout << "\n";
     }
 
+    // Sensitivities are stored as sparse matrices, one per base currency (the pricers
+    // already convert into the base currency when there is a single one)
+    const std::vector<string> sens_ccys = multi ? base_ccys : std::vector<string>();
+
+    // kept to derive PV01 parallel from it
+    std::vector<SensitivityMatrix> pv01_bucketed;
+
     {   // Compute PV01 Bucketed (i.e. sensitivity with respect to individual yield curve points)
-        std::vector<std::pair<string, portfolio_values_t>> pv01_bucketed(compute_pv01_bucketed(pricers,mkt,fds.get()));
+        {
+            perf::ScopedPhase phase("compute_pv01_bucketed");
+            pv01_bucketed = compute_pv01_bucketed_sparse(pricers, mkt, fds.get(), sens_ccys, bumps);
+        }
+        perf::ScopedPhase phase("print");
 
         // display PV01 Bucketed per tenor
-        for (const auto& g : pv01_bucketed)
-            print_price_vector("PV01 bucketed " + g.first, g.second);
+        for (size_t b = 0; b < outs.size(); ++b)
+            for (size_t f = 0; f < pv01_bucketed[b].n_factors(); ++f)
+                report(b, "PV01 bucketed " + pv01_bucketed[b].factor(f), pv01_bucketed[b], f);
     }
 
     {   // Compute PV01 Parallel (i.e. sensitivity with respect to parallel shift of yield curves)
-        std::vector<std::pair<string, portfolio_values_t>> pv01_parallel(compute_pv01_parallel(pricers,mkt,fds.get()));
+        std::vector<SensitivityMatrix> pv01_parallel;
+        {
+            perf::ScopedPhase phase("compute_pv01_parallel");
+            if (parallel_mode == parallel_bucketed)
+                pv01_parallel = pv01_parallel_from_bucketed(pv01_bucketed);
+            else
+                pv01_parallel = compute_pv01_parallel_sparse(pricers, mkt, fds.get(), sens_ccys, bumps);
+        }
+        if (parallel_mode == parallel_check) {
+            std::vector<SensitivityMatrix> derived = pv01_parallel_from_bucketed(pv01_bucketed);
+            for (size_t b = 0; b < outs.size(); ++b)
+                check_pv01_parallel(pv01_parallel[b], derived[b], base_ccys[b]);
+        }
+        pv01_bucketed.clear();
+        perf::ScopedPhase phase("print");
 
         // display PV01 Parallel per currency
-        for (const auto& g : pv01_parallel)
-            print_price_vector("PV01 parallel " + g.first, g.second);
+        for (size_t b = 0; b < outs.size(); ++b)
+            for (size_t f = 0; f < pv01_parallel[b].n_factors(); ++f)
+                report(b, "PV01 parallel " + pv01_parallel[b].factor(f), pv01_parallel[b], f);
     }
 
     {   // Compute FX delta (sensitivity wrt FX spot quoted against USD)
-        std::vector<std::pair<string, portfolio_values_t>> fx_delta(compute_fx_delta(pricers, mkt, fds.get()));
-
-        // Determine relevant FX currencies from portfolio and base currency
-        std::set<string> trade_ccys;
-        for (const auto& t : portfolio) {
-            const TradePayment* tp = dynamic_cast<const TradePayment*>(t.get());
-            if (tp) trade_ccys.insert(tp->ccy());
+        std::vector<SensitivityMatrix> fx_delta;
+        {
+            perf::ScopedPhase phase("compute_fx_delta");
+            fx_delta = compute_fx_delta_sparse(pricers, mkt, fds.get(), sens_ccys, bumps);
         }
-        std::set<string> fx_ccys = trade_ccys;
-        fx_ccys.insert(base_ccy);
-        bool needs_usd = (base_ccy != "USD");
-        if (needs_usd) {
-            for (const auto& c : trade_ccys) {
-                if (c != "USD" && c != base_ccy) { needs_usd = true; break; }
-                needs_usd = false;
+        perf::ScopedPhase phase("print");
+
+        // display FX delta only for the FX spots each base currency depends on (with several
+        // base currencies, those converting into the others are bumped as well)
+        for (size_t b = 0; b < outs.size(); ++b) {
+            for (size_t f = 0; f < fx_delta[b].n_factors(); ++f) {
+                const string& name = fx_delta[b].factor(f);
+                if (risk_factors[b].count(name))
+                    report(b, "FX delta " + name, fx_delta[b], f);
             }
         }
-        if (needs_usd) fx_ccys.insert("USD");
-
-        // display FX delta only for relevant currencies
-        for (const auto& g : fx_delta) {
-            // g.first is like "FX.SPOT.CCY"
-            const string prefix = fx_spot_prefix; // e.g. "FX.SPOT."
-            string ccy = (g.first.size() > prefix.size()) ? g.first.substr(prefix.size()) : g.first;
-            if (fx_ccys.count(ccy))
-                print_price_vector("FX delta " + g.first, g.second);
-        }
     }
 
     // disconnect the market (no more fetching from the market data server allowed)
     mkt.disconnect();
+
+    for (auto& c : cubes)
+        c->close();
 }
 
 void usage(const char* program_name)
 {
     std::cerr
-        << "Usage: " << program_name << " -p <portfolio_file> -f <risk_factors_file> [-b <base_currency>] [-x <fixings_file>]\n"
+        << "Usage: " << program_name << " -p <portfolio_file> -f <risk_factors_file> [-b <base_currency>[,<base_currency>...]] [-x <fixings_file>] [-o <output_prefix>] [-z 1] [-r <results_prefix>] [-j <threads>] [-d <scheme>] [-u <ir_bump_bp>] [-v <fx_bump_pct>] [-P <pv01_parallel>] [-s <stats_file> [-H 1] [-L 1]] [-t <trace_file>]\n"
         << "\n"
         << "Required arguments:\n"
         << "  -p <portfolio_file>        Path to the portfolio file\n"
         << "  -f <risk_factors_file>      Path to the risk factors file\n"
         << "\n"
         << "Optional arguments:\n"
-        << "  -b <base_currency>         Base currency (default: USD)\n"
+        << "  -b <base_currency>         Base currency (default: USD). A comma separated list\n"
+        << "                             prices once and produces one report per base currency\n"
         << "  -x <fixings_file>          Path to the fixings file (optional)\n"
+        << "  -o <output_prefix>         Write each report to <output_prefix>_<base_currency>.txt\n"
+        << "                             instead of stdout\n"
+        << "  -z 1                       Sparse sensitivity reports: list only the trades with\n"
+        << "                             a non zero sensitivity (or an error)\n"
+        << "  -r <results_prefix>        Also write the results of each report in binary to\n"
+        << "                             <results_prefix>_<base_currency>.bin (see DemoDumpResults)\n"
+        << "  -j <threads>               Threads pricing the portfolio and the bump scenarios\n"
+        << "                             (default: hardware concurrency)\n"
+        << "  -d <scheme>                Finite differences: central (default), or forward,\n"
+        << "                             repricing once per risk factor from the base PV\n"
+        << "  -u <ir_bump_bp>            Bump of the IR rates in basis points (default: 1)\n"
+        << "  -v <fx_bump_pct>           Relative bump of the FX spots in percent (default: 0.1)\n"
+        << "  -P <pv01_parallel>         PV01 parallel: full (default) reprices with each curve\n"
+        << "                             shifted, bucketed sums the PV01 bucketed (exact for\n"
+        << "                             products linear in the curve), check computes both and\n"
+        << "                             reports the trades where they differ on stderr\n"
+        << "  -s <stats_file>            Write phase timings and performance counters as JSON\n"
+        << "  -H 1                       Add hardware counters to the phases in the stats file:\n"
+        << "                             IPC, LLC and branch misses per trade priced\n"
+        << "  -L 1                       Add latency percentiles per pricer type, per scenario\n"
+        << "                             and per curve construction to the stats file\n"
+        << "  -t <trace_file>            Write a timeline of the run in Chrome trace format\n"
+        << "                             (open with chrome://tracing or ui.perfetto.dev)\n"
         << "\n"
         << "Examples:\n"
         << "  " << program_name << " -p data/portfolio_00.txt -f data/risk_factors_0.txt\n"
         << "  " << program_name << " -p data/portfolio_04.txt -f data/risk_factors_3.txt -b GBP\n"
-        << "  " << program_name << " -p data/portfolio_04.txt -f data/risk_factors_3.txt -b GBP -x data/fixings.txt\n";
+        << "  " << program_name << " -p data/portfolio_04.txt -f data/risk_factors_3.txt -b GBP -x data/fixings.txt\n"
+        << "  " << program_name << " -p data/portfolio_10.txt -f data/risk_factors_3.txt -b USD,GBP -x data/fixings.txt -o output_10\n";
     std::exit(1);
 }
 
@@ -190,8 +323,15 @@ int main(int argc, const char **argv)
     
     // parse command line arguments
     string portfolio, riskfactors;
-    string base_ccy = "USD";
+    std::vector<string> base_ccys(1, "USD");
     string fixings_file;
+    string output_prefix;
+    bool sparse = false;
+    string results_prefix;
+    string stats_file;
+    string trace_file;
+    bump_settings_t bumps;
+    pv01_parallel_mode_t parallel_mode = parallel_full;
     
     // Validate argument count (must be odd: program name + pairs of key-value)
     if (argc < 5 || argc % 2 == 0) {
@@ -232,9 +372,61 @@ int main(int argc, const char **argv)
             riskfactors = value;
             has_riskfactors = true;
         } else if (key == "-b") {
-            base_ccy = value;
+            // comma separated list of base currencies
+            base_ccys.clear();
+            std::istringstream is(value);
+            for (string ccy; std::getline(is, ccy, ',');)
+                base_ccys.push_back(ccy);
         } else if (key == "-x") {
             fixings_file = value;
+        } else if (key == "-o") {
+            output_prefix = value;
+        } else if (key == "-z") {
+            sparse = value != "0";
+        } else if (key == "-r") {
+            results_prefix = value;
+        } else if (key == "-j") {
+            TaskScheduler::set_global_threads(std::max(1, std::atoi(value.c_str())));
+        } else if (key == "-d") {
+            if (value == "central") {
+                bumps.scheme = bump_settings_t::central;
+            } else if (value == "forward") {
+                bumps.scheme = bump_settings_t::forward;
+            } else {
+                std::cerr << "Error: Unknown finite difference scheme: " << value << "\n\n";
+                usage(argv[0]);
+            }
+        } else if (key == "-u" || key == "-v") {
+            double bump = std::atof(value.c_str());
+            if (!(bump > 0.0)) {
+                std::cerr << "Error: Bump size must be positive, got: " << value << "\n\n";
+                usage(argv[0]);
+            }
+            if (key == "-u")
+                bumps.ir_bump = bump / 10000;
+            else
+                bumps.fx_rel_bump = bump / 100;
+        } else if (key == "-P") {
+            if (value == "full") {
+                parallel_mode = parallel_full;
+            } else if (value == "bucketed") {
+                parallel_mode = parallel_bucketed;
+            } else if (value == "check") {
+                parallel_mode = parallel_check;
+            } else {
+                std::cerr << "Error: Unknown PV01 parallel mode: " << value << "\n\n";
+                usage(argv[0]);
+            }
+        } else if (key == "-s") {
+            stats_file = value;
+            perf::enable();
+        } else if (key == "-L") {
+            perf::enable_latency(value != "0");
+        } else if (key == "-H") {
+            perf::enable_hw(value != "0");
+        } else if (key == "-t") {
+            trace_file = value;
+            trace::enable();
         } else {
             std::cerr << "Error: Unknown argument: " << key << "\n\n";
             usage(argv[0]);
@@ -247,20 +439,43 @@ int main(int argc, const char **argv)
         usage(argv[0]);
     }
 
+    if (perf::hw_enabled() && !perf::this_thread_hw_counters().status().empty())
+        std::cerr << "Hardware counters: " << perf::this_thread_hw_counters().status() << "\n";
+
+    int rc = 0;
     try {
-        run(portfolio, riskfactors, base_ccy, fixings_file);
-        return 0;  // report success to the caller
+        run(portfolio, riskfactors, base_ccys, fixings_file, output_prefix, sparse, results_prefix, bumps, parallel_mode);
     }
     catch (const std::exception& e)
     {
         std::cerr << e.what() << "\n";
-        return -1; // report an error to the caller
+        rc = -1; // report an error to the caller
     }
     catch (...)
     {
         std::cerr << "Unknown exception occurred\n";
-        return -1; // report an error to the caller
+        rc = -1; // report an error to the caller
+    }
+
+    // performance summary, also for failed runs
+    if (!stats_file.empty()) {
+        std::ofstream os(stats_file);
+        if (os.fail())
+            std::cerr << "Could not open file " << stats_file << "\n";
+        else
+            perf::write_json(os);
     }
+
+    // timeline of the run
+    if (!trace_file.empty()) {
+        std::ofstream os(trace_file);
+        if (os.fail())
+            std::cerr << "Could not open file " << trace_file << "\n";
+        else
+            trace::write_json(os);
+    }
+
+    return rc;
 }
 
 // Under src folder: make
@@ -272,3 +487,10 @@ int main(int argc, const char **argv)
 // src/bin/DemoRisk.exe -p data/portfolio_04.txt -f data/risk_factors_3.txt -x data/fixings.txt
 // src/bin/DemoRisk.exe -p data/portfolio_10.txt -f data/risk_factors_3.txt -x data/fixings.txt
 // src/bin/DemoRisk.exe -p data/portfolio_10.txt -f data/risk_factors_3.txt -b GBP -x data/fixings.txt
+// src/bin/DemoRisk.exe -p data/portfolio_10.txt -f data/risk_factors_3.txt -b USD,GBP -x data/fixings.txt -o output_10
+// src/bin/DemoRisk.exe -p data/portfolio_10.txt -f data/risk_factors_3.txt -x data/fixings.txt -z 1
+// src/bin/DemoRisk.exe -p data/portfolio_10.txt -f data/risk_factors_3.txt -b USD,GBP -x data/fixings.txt -r results_10
+// src/bin/DemoRisk.exe -p data/portfolio_10.txt -f data/risk_factors_3.txt -x data/fixings.txt -s stats_10.json
+// src/bin/DemoRisk.exe -p data/portfolio_10.txt -f data/risk_factors_3.txt -x data/fixings.txt -t trace_10.json
+// src/bin/DemoRisk.exe -p data/portfolio_10.txt -f data/risk_factors_3.txt -x data/fixings.txt -s stats_10.json -H 1
+// src/bin/DemoRisk.exe -p data/portfolio_10.txt -f data/risk_factors_3.txt -x data/fixings.txt -s stats_10.json -L 1
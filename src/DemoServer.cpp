@@ -0,0 +1,299 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "Macros.h"
+#include "MarketDataServer.h"
+#include "PortfolioUtils.h"
+#include "FixingDataServer.h"
+#include "LocalSocket.h"
+#include "LivePortfolio.h"
+#include "LatencyHistogram.h"
+
+using namespace::minirisk;
+
+// Keeps market, fixings and a live portfolio with cached prices and sensitivities resident
+// between requests.
+//
+// Protocol (one request per line):
+//   INSERT <id> <trade>         book a trade in the portfolio file format, e.g. INSERT T1 0;20;EUR;42949;
+//   AMEND <id> <trade>          replace a trade
+//   CANCEL <id>                 remove a trade
+//   ADD <trade>                 book a trade with an id assigned by the server, which is returned
+//   REMOVE <id>                 same as CANCEL
+//   SET <name> <value> [...]    update one or more risk factors
+//   PV                          per trade PV and total
+//   PV01                        PV01 parallel totals per currency
+//   PV01_BUCKETED               PV01 bucketed totals per tenor
+//   FXDELTA                     FX delta totals per FX spot
+//   LATENCY                     latency percentiles (us) since startup: name;count;p50;p99;p99.9;max
+//   SHUTDOWN                    stop the server
+// Each reply starts with "OK <elapsed microseconds>" or "ERROR <message>", is followed by
+// zero or more result lines and is terminated by an empty line.
+struct RiskServer
+{
+    RiskServer(const string& risk_factors_file, const string& base_ccy, const string& fixings_file)
+        : m_mds(new MarketDataServer(risk_factors_file))
+        , m_fds(fixings_file.empty() ? nullptr : new FixingDataServer(fixings_file))
+        , m_mkt(cached_market(m_mds))
+        , m_live(m_mkt, m_fds.get(), base_ccy)
+        , m_next_id(0)
+        , m_shutdown(false)
+    {
+    }
+
+    // book a trade with an id assigned by the server
+    string add(const ptrade_t& trade)
+    {
+        string id;
+        do {
+            id = std::to_string(m_next_id++);
+        } while (m_live.contains(id));
+        m_live.insert(id, trade);
+        return id;
+    }
+
+    // process one request, writing the result lines to os
+    void process(const string& request, std::ostream& os)
+    {
+        std::istringstream is(request);
+        string cmd, id, line;
+        is >> cmd;
+
+        if (cmd == "INSERT") {
+            MYASSERT(is >> id >> line, "Expected: INSERT <id> <trade>");
+            m_live.insert(id, parse_trade(line));
+        } else if (cmd == "AMEND") {
+            MYASSERT(is >> id >> line, "Expected: AMEND <id> <trade>");
+            m_live.amend(id, parse_trade(line));
+        } else if (cmd == "CANCEL" || cmd == "REMOVE") {
+            MYASSERT(is >> id, "Expected: " << cmd << " <id>");
+            m_live.cancel(id);
+        } else if (cmd == "ADD") {
+            MYASSERT(is >> line, "Expected: ADD <trade>");
+            os << add(parse_trade(line)) << "\n";
+        } else if (cmd == "SET") {
+            // parse the whole request before applying any of it
+            Market::vec_risk_factor_t rf;
+            string name, value;
+            while (is >> name) {
+                MYASSERT(is >> value, "Missing value for risk factor " << name);
+                char* end;
+                const double v = std::strtod(value.c_str(), &end);
+                MYASSERT(end == value.c_str() + value.size() && std::isfinite(v), "Invalid value for risk factor " << name << ": " << value);
+                rf.emplace_back(name, v);
+            }
+            MYASSERT(!rf.empty(), "Missing risk factor values");
+            m_live.update(rf);
+        } else if (cmd == "PV") {
+            for (const auto& i : m_live.ids()) {
+                const auto& pv = m_live.price(i);
+                os << i << separator;
+                if (std::isnan(pv.first))
+                    os << pv.second << "\n";
+                else
+                    os << pv.first << "\n";
+            }
+            print_total("TOTAL", m_live.total(), os);
+        } else if (cmd == "PV01") {
+            // parallel shifts are not maintained incrementally: reprice the whole book
+            std::vector<ppricer_t> pricers;
+            for (const auto& i : m_live.ids())
+                pricers.push_back(m_live.pricer(i));
+            if (!pricers.empty())
+                for (const auto& g : compute_pv01_parallel(pricers, m_mkt, m_fds.get()))
+                    print_total(g.first, portfolio_total(g.second), os);
+        } else if (cmd == "PV01_BUCKETED") {
+            print_totals(ir_rate_prefix, os);
+        } else if (cmd == "FXDELTA") {
+            print_totals(fx_spot_prefix, os);
+        } else if (cmd == "LATENCY") {
+            perf::print_latency(os);
+        } else if (cmd == "SHUTDOWN") {
+            m_shutdown = true;
+        } else {
+            THROW("Unknown request: " << cmd);
+        }
+    }
+
+    // serve all requests of a client connection
+    void serve(LocalSocket& client)
+    {
+        string request;
+        while (!m_shutdown && client.read_line(request)) {
+            if (request.empty())
+                continue;
+            std::ostringstream os;
+            os << std::setprecision(17);
+            string reply;
+            auto t0 = std::chrono::steady_clock::now();
+            try {
+                process(request, os);
+                auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+                reply = "OK " + std::to_string(us) + "\n" + os.str();
+            } catch (const std::exception& e) {
+                reply = string("ERROR ") + e.what() + "\n";
+            }
+            client.write(reply + "\n");
+        }
+    }
+
+    bool shutdown() const { return m_shutdown; }
+
+private:
+    // market with all risk factors cached, so that they can be updated and bumped
+    static Market cached_market(const std::shared_ptr<const MarketDataServer>& mds)
+    {
+        Market mkt(mds, Date(2017,8,5));
+        for (const auto& rf : mds->match(".+"))
+            mkt.get_value(rf, "risk factor");
+        return mkt;
+    }
+
+    template <typename T>
+    static void print_total(const string& name, const T& total, std::ostream& os)
+    {
+        os << name << separator << total.first << separator << total.second.size() << "\n";
+    }
+
+    static void print_total(const string& name, const LivePortfolio::total_t& total, std::ostream& os)
+    {
+        os << name << separator << total.first << separator << total.second << "\n";
+    }
+
+    // maintained sensitivity totals of the risk factors starting with prefix
+    void print_totals(const string& prefix, std::ostream& os) const
+    {
+        for (const auto& s : m_live.sensitivities())
+            if (s.first.compare(0, prefix.size(), prefix) == 0)
+                print_total(s.first, s.second, os);
+    }
+
+    std::shared_ptr<const MarketDataServer> m_mds;
+    std::unique_ptr<FixingDataServer> m_fds;
+    Market m_mkt;
+    LivePortfolio m_live;
+    unsigned m_next_id;
+    bool m_shutdown;
+};
+
+void run(const string& socket_path, const string& portfolio_file, const string& risk_factors_file, const string& base_ccy, const string& fixings_file)
+{
+    MYASSERT(base_ccy.length() == 3, "Base currency must be 3 characters (ISO 4217 code), got: " << base_ccy);
+
+    // latency histograms are cheap enough to be always on
+    perf::enable_latency();
+
+    RiskServer server(risk_factors_file, base_ccy, fixings_file);
+
+    // trades of the initial portfolio get ids 0, 1, ...
+    if (!portfolio_file.empty())
+        for (const auto& t : load_portfolio(portfolio_file))
+            server.add(t);
+
+    LocalSocket listener = LocalSocket::listen(socket_path);
+    std::cerr << "Listening on " << socket_path << "\n";
+
+    // requests are served one at a time, so the market and the pricers need no locking
+    while (!server.shutdown()) {
+        LocalSocket client(listener.accept());
+        try {
+            server.serve(client);
+        } catch (const std::exception& e) {
+            std::cerr << "Client connection error: " << e.what() << "\n";
+        }
+    }
+
+    listener.close();
+    ::unlink(socket_path.c_str());
+}
+
+void usage(const char* program_name)
+{
+    std::cerr
+        << "Usage: " << program_name << " -s <socket_path> -f <risk_factors_file> [-p <portfolio_file>] [-b <base_currency>] [-x <fixings_file>]\n"
+        << "\n"
+        << "Required arguments:\n"
+        << "  -s <socket_path>           Path of the Unix domain socket to listen on\n"
+        << "  -f <risk_factors_file>     Path to the risk factors file\n"
+        << "\n"
+        << "Optional arguments:\n"
+        << "  -p <portfolio_file>        Initial portfolio (default: empty)\n"
+        << "  -b <base_currency>         Base currency (default: USD)\n"
+        << "  -x <fixings_file>          Path to the fixings file (optional)\n"
+        << "\n"
+        << "Example:\n"
+        << "  " << program_name << " -s /tmp/minirisk.sock -f data/risk_factors_3.txt -p data/portfolio_10.txt -x data/fixings.txt\n";
+    std::exit(1);
+}
+
+int main(int argc, const char **argv)
+{
+    // Handle no arguments case
+    if (argc == 1) {
+        usage(argv[0]);
+    }
+
+    string socket_path, portfolio, riskfactors, fixings_file;
+    string base_ccy = "USD";
+
+    // Validate argument count (must be odd: program name + pairs of key-value)
+    if (argc % 2 == 0) {
+        std::cerr << "Error: Invalid number of arguments.\n\n";
+        usage(argv[0]);
+    }
+
+    for (int i = 1; i < argc; i += 2) {
+        string key(argv[i]);
+        string value(argv[i+1]);
+
+        if (value.empty()) {
+            std::cerr << "Error: Empty value provided for argument: " << key << "\n\n";
+            usage(argv[0]);
+        }
+
+        if (key == "-s") {
+            socket_path = value;
+        } else if (key == "-p") {
+            portfolio = value;
+        } else if (key == "-f") {
+            riskfactors = value;
+        } else if (key == "-b") {
+            base_ccy = value;
+        } else if (key == "-x") {
+            fixings_file = value;
+        } else {
+            std::cerr << "Error: Unknown argument: " << key << "\n\n";
+            usage(argv[0]);
+        }
+    }
+
+    if (socket_path.empty() || riskfactors.empty()) {
+        std::cerr << "Error: Missing required arguments.\n\n";
+        usage(argv[0]);
+    }
+
+    try {
+        run(socket_path, portfolio, riskfactors, base_ccy, fixings_file);
+        return 0;  // report success to the caller
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return -1; // report an error to the caller
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown exception occurred\n";
+        return -1; // report an error to the caller
+    }
+}
+
+// Under src folder: make
+// src/bin/DemoServer.exe -s /tmp/minirisk.sock -f data/risk_factors_3.txt -p data/portfolio_10.txt -x data/fixings.txt
+// src/bin/DemoClient.exe -s /tmp/minirisk.sock PV
@@ -0,0 +1,135 @@
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+
+#include "Macros.h"
+#include "ShardedRisk.h"
+
+using namespace::minirisk;
+
+// Helper function to check if file exists
+static bool file_exists(const string& filename)
+{
+    std::ifstream file(filename);
+    return file.good();
+}
+
+void run(const string& portfolio_file, const string& risk_factors_file, const string& base_ccy, const string& fixings_file, const string& output_file, unsigned n_workers, unsigned n_threads)
+{
+    MYASSERT(file_exists(portfolio_file), "Portfolio file does not exist: " << portfolio_file);
+    MYASSERT(file_exists(risk_factors_file), "Risk factors file does not exist: " << risk_factors_file);
+    if (!fixings_file.empty()) {
+        MYASSERT(file_exists(fixings_file), "Fixings file does not exist: " << fixings_file);
+    }
+    MYASSERT(base_ccy.length() == 3, "Base currency must be 3 characters (ISO 4217 code), got: " << base_ccy);
+
+    sharded_result_t res = run_sharded(portfolio_file, risk_factors_file, base_ccy, fixings_file, n_workers, n_threads);
+
+    std::cerr << "Trades: " << res.trades << ", workers: " << res.workers << "\n";
+
+    std::ofstream of;
+    if (!output_file.empty()) {
+        of.open(output_file);
+        MYASSERT(!of.fail(), "Could not open file " << output_file);
+    }
+    std::ostream& os = output_file.empty() ? std::cout : of;
+    for (const auto& m : res.measures)
+        print_price_vector(m.first, m.second, os);
+}
+
+void usage(const char* program_name)
+{
+    std::cerr
+        << "Usage: " << program_name << " -p <portfolio_file> -f <risk_factors_file> [-b <base_currency>] [-x <fixings_file>] [-n <workers>] [-j <threads>] [-o <output_file>]\n"
+        << "\n"
+        << "Computes PV and sensitivities of a portfolio on several processes, each pricing a\n"
+        << "contiguous shard of the trades against a market snapshot in shared memory. The\n"
+        << "results are merged in portfolio order and do not depend on the number of workers.\n"
+        << "\n"
+        << "Required arguments:\n"
+        << "  -p <portfolio_file>        Path to the portfolio file\n"
+        << "  -f <risk_factors_file>     Path to the risk factors file\n"
+        << "\n"
+        << "Optional arguments:\n"
+        << "  -b <base_currency>         Base currency (default: USD)\n"
+        << "  -x <fixings_file>          Path to the fixings file (optional)\n"
+        << "  -n <workers>               Number of worker processes (default: 1)\n"
+        << "  -j <threads>               Threads per worker process (default: 1, 0 for the\n"
+        << "                             hardware concurrency)\n"
+        << "  -o <output_file>           Write the results to this file instead of stdout\n"
+        << "\n"
+        << "Example:\n"
+        << "  " << program_name << " -p data/portfolio_10.txt -f data/risk_factors_3.txt -x data/fixings.txt -n 4\n";
+    std::exit(1);
+}
+
+int main(int argc, const char **argv)
+{
+    // Handle no arguments case
+    if (argc == 1) {
+        usage(argv[0]);
+    }
+
+    string portfolio, riskfactors, output, fixings_file;
+    string base_ccy = "USD";
+    unsigned n_workers = 1;
+    unsigned n_threads = 1;
+
+    // Validate argument count (must be odd: program name + pairs of key-value)
+    if (argc % 2 == 0) {
+        std::cerr << "Error: Invalid number of arguments.\n\n";
+        usage(argv[0]);
+    }
+
+    for (int i = 1; i < argc; i += 2) {
+        string key(argv[i]);
+        string value(argv[i+1]);
+
+        if (value.empty()) {
+            std::cerr << "Error: Empty value provided for argument: " << key << "\n\n";
+            usage(argv[0]);
+        }
+
+        if (key == "-p") {
+            portfolio = value;
+        } else if (key == "-f") {
+            riskfactors = value;
+        } else if (key == "-o") {
+            output = value;
+        } else if (key == "-b") {
+            base_ccy = value;
+        } else if (key == "-x") {
+            fixings_file = value;
+        } else if (key == "-n") {
+            n_workers = static_cast<unsigned>(std::max(1, std::atoi(value.c_str())));
+        } else if (key == "-j") {
+            n_threads = static_cast<unsigned>(std::max(0, std::atoi(value.c_str())));
+        } else {
+            std::cerr << "Error: Unknown argument: " << key << "\n\n";
+            usage(argv[0]);
+        }
+    }
+
+    if (portfolio.empty() || riskfactors.empty()) {
+        std::cerr << "Error: Missing required arguments.\n\n";
+        usage(argv[0]);
+    }
+
+    try {
+        run(portfolio, riskfactors, base_ccy, fixings_file, output, n_workers, n_threads);
+        return 0;  // report success to the caller
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return -1; // report an error to the caller
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown exception occurred\n";
+        return -1; // report an error to the caller
+    }
+}
+
+// Under src folder: make
+// src/bin/DemoShard.exe -p data/portfolio_10.txt -f data/risk_factors_3.txt -x data/fixings.txt -n 4
@@ -0,0 +1,123 @@
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+
+#include "Macros.h"
+#include "MarketDataServer.h"
+#include "FixingDataServer.h"
+#include "StreamingRisk.h"
+
+using namespace::minirisk;
+
+void run(const string& portfolio_file, const string& risk_factors_file, const string& base_ccy, const string& fixings_file, const string& output_file, size_t memory_mb)
+{
+    std::shared_ptr<const MarketDataServer> mds(new MarketDataServer(risk_factors_file));
+    std::unique_ptr<FixingDataServer> fds;
+    if (!fixings_file.empty())
+        fds.reset(new FixingDataServer(fixings_file));
+
+    // cache all risk factors, so that every block is bumped on the same set
+    Date today(2017,8,5);
+    Market mkt(mds, today);
+    for (const auto& rf : mds->match(".+"))
+        mkt.get_value(rf, "risk factor");
+
+    streaming_result_t res = stream_risk(portfolio_file, base_ccy, mkt, fds.get(), memory_mb << 20, output_file);
+
+    std::cerr << "Trades: " << res.trades << ", blocks: " << res.blocks << " of up to " << res.block_size << " trades\n";
+
+    // measure;total;errors
+    for (const auto& t : res.totals)
+        std::cout << std::get<0>(t) << separator << std::get<1>(t) << separator << std::get<2>(t) << "\n";
+}
+
+void usage(const char* program_name)
+{
+    std::cerr
+        << "Usage: " << program_name << " -p <portfolio_file> -f <risk_factors_file> -o <output_file> [-b <base_currency>] [-x <fixings_file>] [-m <memory_mb>]\n"
+        << "\n"
+        << "Computes PV and sensitivities of a portfolio too large to fit in memory, reading it in\n"
+        << "blocks. Per trade results are written to the output file, totals to stdout.\n"
+        << "\n"
+        << "Required arguments:\n"
+        << "  -p <portfolio_file>        Path to the portfolio file\n"
+        << "  -f <risk_factors_file>     Path to the risk factors file\n"
+        << "  -o <output_file>           Path to the per trade results file\n"
+        << "\n"
+        << "Optional arguments:\n"
+        << "  -b <base_currency>         Base currency (default: USD)\n"
+        << "  -x <fixings_file>          Path to the fixings file (optional)\n"
+        << "  -m <memory_mb>             Memory ceiling of a block in MB (default: 256)\n"
+        << "\n"
+        << "Example:\n"
+        << "  " << program_name << " -p data/portfolio_10.txt -f data/risk_factors_3.txt -x data/fixings.txt -o stream_10.txt -m 1\n";
+    std::exit(1);
+}
+
+int main(int argc, const char **argv)
+{
+    // Handle no arguments case
+    if (argc == 1) {
+        usage(argv[0]);
+    }
+
+    string portfolio, riskfactors, output, fixings_file;
+    string base_ccy = "USD";
+    size_t memory_mb = 256;
+
+    // Validate argument count (must be odd: program name + pairs of key-value)
+    if (argc % 2 == 0) {
+        std::cerr << "Error: Invalid number of arguments.\n\n";
+        usage(argv[0]);
+    }
+
+    for (int i = 1; i < argc; i += 2) {
+        string key(argv[i]);
+        string value(argv[i+1]);
+
+        if (value.empty()) {
+            std::cerr << "Error: Empty value provided for argument: " << key << "\n\n";
+            usage(argv[0]);
+        }
+
+        if (key == "-p") {
+            portfolio = value;
+        } else if (key == "-f") {
+            riskfactors = value;
+        } else if (key == "-o") {
+            output = value;
+        } else if (key == "-b") {
+            base_ccy = value;
+        } else if (key == "-x") {
+            fixings_file = value;
+        } else if (key == "-m") {
+            memory_mb = std::max(1, std::atoi(value.c_str()));
+        } else {
+            std::cerr << "Error: Unknown argument: " << key << "\n\n";
+            usage(argv[0]);
+        }
+    }
+
+    if (portfolio.empty() || riskfactors.empty() || output.empty()) {
+        std::cerr << "Error: Missing required arguments.\n\n";
+        usage(argv[0]);
+    }
+
+    try {
+        run(portfolio, riskfactors, base_ccy, fixings_file, output, memory_mb);
+        return 0;  // report success to the caller
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return -1; // report an error to the caller
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown exception occurred\n";
+        return -1; // report an error to the caller
+    }
+}
+
+// Under src folder: make
+// src/bin/DemoStream.exe -p data/portfolio_10.txt -f data/risk_factors_3.txt -x data/fixings.txt -o stream_10.txt -m 1
@@ -0,0 +1,259 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <tuple>
+#include <cmath>
+
+#include "Macros.h"
+#include "MarketDataServer.h"
+#include "PortfolioUtils.h"
+#include "FixingDataServer.h"
+#include "TaskScheduler.h"
+#include "Trace.h"
+
+using namespace::minirisk;
+
+// One valuation date of the sweep and the risk factors to use on that date
+struct sweep_point_t
+{
+    Date today;
+    string risk_factors_file;
+};
+
+// Portfolio totals computed on one valuation date
+struct sweep_result_t
+{
+    // (measure, risk factor, total, number of trades in error)
+    typedef std::tuple<string, string, double, size_t> row_t;
+    std::vector<row_t> rows;
+    string error;  // set if the whole date could not be processed
+};
+
+// Schedule file format, one valuation date per line: YYYYMMDD <risk_factors_file>
+static std::vector<sweep_point_t> load_schedule(const string& filename)
+{
+    std::ifstream is(filename);
+    MYASSERT(!is.fail(), "Could not open file " << filename);
+
+    std::vector<sweep_point_t> schedule;
+    string yyyymmdd, rf_file;
+    while (is >> yyyymmdd >> rf_file) {
+        MYASSERT(yyyymmdd.size() == 8, "Invalid date format (expected YYYYMMDD): " << yyyymmdd);
+        unsigned y = std::stoul(yyyymmdd.substr(0, 4));
+        unsigned m = std::stoul(yyyymmdd.substr(4, 2));
+        unsigned d = std::stoul(yyyymmdd.substr(6, 2));
+        schedule.push_back(sweep_point_t{ Date(y, m, d), rf_file });
+    }
+    MYASSERT(!schedule.empty(), "Empty schedule file: " << filename);
+    return schedule;
+}
+
+static void add_row(sweep_result_t& res, const string& measure, const string& name, const portfolio_values_t& values)
+{
+    auto total = portfolio_total(values);
+    res.rows.emplace_back(measure, name, total.first, total.second.size());
+}
+
+// Revalue the portfolio on one date: PV, one-day theta, and the sensitivity totals
+static sweep_result_t revalue(const std::vector<ppricer_t>& pricers, const sweep_point_t& point, const FixingDataServer* fds)
+{
+    sweep_result_t res;
+    trace::ScopedEvent event("revalue", "sweep", point.risk_factors_file);
+    try {
+        std::shared_ptr<const MarketDataServer> mds(new MarketDataServer(point.risk_factors_file));
+        Market mkt(mds, point.today);
+
+        auto pv = compute_prices(pricers, mkt, fds);
+        add_row(res, "PV", "", pv);
+
+        // one-day theta: same market data, valuation date rolled forward by one day
+        {
+            Market mkt1(mds, Date(point.today.serial() + 1));
+            auto pv1 = compute_prices(pricers, mkt1, fds);
+            portfolio_values_t theta(pv.size());
+            for (size_t i = 0; i < pv.size(); ++i) {
+                if (std::isnan(pv[i].first))
+                    theta[i] = pv[i];
+                else if (std::isnan(pv1[i].first))
+                    theta[i] = pv1[i];
+                else
+                    theta[i] = std::make_pair(pv1[i].first - pv[i].first, "");
+            }
+            add_row(res, "THETA", "", theta);
+        }
+
+        // load all risk factors, so that all of them are bumped
+        for (const auto& rf : mds->match(".+"))
+            mkt.get_value(rf, "risk factor");
+
+        for (const auto& g : compute_pv01_bucketed(pricers, mkt, fds))
+            add_row(res, "PV01_BUCKETED", g.first, g.second);
+        for (const auto& g : compute_pv01_parallel(pricers, mkt, fds))
+            add_row(res, "PV01_PARALLEL", g.first, g.second);
+        for (const auto& g : compute_fx_delta(pricers, mkt, fds))
+            add_row(res, "FX_DELTA", g.first, g.second);
+    }
+    catch (const std::exception& e) {
+        res.rows.clear();
+        res.error = e.what();
+    }
+    return res;
+}
+
+// Returns the number of valuation dates which failed
+size_t run(const string& portfolio_file, const string& schedule_file, const string& base_ccy, const string& fixings_file, const string& output_file)
+{
+    // portfolio and pricers are built once and shared (read only) by all the workers
+    portfolio_t portfolio = load_portfolio(portfolio_file);
+    std::vector<ppricer_t> pricers(get_pricers(portfolio, base_ccy));
+
+    // fixings are shared by all valuation dates
+    std::unique_ptr<FixingDataServer> fds;
+    if (!fixings_file.empty())
+        fds.reset(new FixingDataServer(fixings_file));
+
+    std::vector<sweep_point_t> schedule = load_schedule(schedule_file);
+    std::vector<sweep_result_t> results(schedule.size());
+
+    // Each task revalues one date and builds its own market, so that no mutable state is
+    // shared among threads (the loops of the risk functions run serially within a task).
+    // Results are stored by position to keep the output ordered.
+    TaskScheduler::global().parallel_for(schedule.size(), 1, [&](unsigned, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            results[i] = revalue(pricers, schedule[i], fds.get());
+    });
+
+    // time series, one row per (date, measure, risk factor), and an ERROR row per failed date
+    my_ofstream of(output_file);
+    MYASSERT(!of.m_of.fail(), "Could not open file " << output_file);
+    of << "date" << "measure" << "risk_factor" << "total" << "errors";
+    of.endl();
+    size_t failed = 0;
+    for (size_t i = 0; i < schedule.size(); ++i) {
+        if (!results[i].error.empty()) {
+            std::cerr << "Valuation date " << schedule[i].today << " failed: " << results[i].error << "\n";
+            of << schedule[i].today << "ERROR" << "" << "" << "";
+            of.endl();
+            ++failed;
+            continue;
+        }
+        for (const auto& r : results[i].rows) {
+            of << schedule[i].today << std::get<0>(r) << std::get<1>(r) << std::get<2>(r) << std::get<3>(r);
+            of.endl();
+        }
+    }
+    of.close();
+    return failed;
+}
+
+void usage(const char* program_name)
+{
+    std::cerr
+        << "Usage: " << program_name << " -p <portfolio_file> -s <schedule_file> -o <output_file> [-b <base_currency>] [-x <fixings_file>] [-n <threads>] [-t <trace_file>]\n"
+        << "\n"
+        << "Revalues the portfolio on each date of the schedule. A date which cannot be revalued\n"
+        << "is reported on stderr and written as a row date;ERROR, and the exit code is non-zero.\n"
+        << "\n"
+        << "Required arguments:\n"
+        << "  -p <portfolio_file>        Path to the portfolio file\n"
+        << "  -s <schedule_file>         Valuation dates, one per line: YYYYMMDD <risk_factors_file>\n"
+        << "  -o <output_file>           Path to the time series output file\n"
+        << "\n"
+        << "Optional arguments:\n"
+        << "  -b <base_currency>         Base currency (default: USD)\n"
+        << "  -x <fixings_file>          Path to the fixings file (optional)\n"
+        << "  -n <threads>               Number of worker threads (default: hardware concurrency)\n"
+        << "  -t <trace_file>            Write a timeline of the run in Chrome trace format\n"
+        << "\n"
+        << "Example:\n"
+        << "  " << program_name << " -p data/portfolio_10.txt -s data/sweep_schedule.txt -o sweep_10.txt -x data/fixings.txt\n";
+    std::exit(1);
+}
+
+int main(int argc, const char **argv)
+{
+    // Handle no arguments case
+    if (argc == 1) {
+        usage(argv[0]);
+    }
+
+    string portfolio, schedule, output;
+    string base_ccy = "USD";
+    string fixings_file;
+    string trace_file;
+
+    // Validate argument count (must be odd: program name + pairs of key-value)
+    if (argc % 2 == 0) {
+        std::cerr << "Error: Invalid number of arguments.\n\n";
+        usage(argv[0]);
+    }
+
+    for (int i = 1; i < argc; i += 2) {
+        string key(argv[i]);
+        string value(argv[i+1]);
+
+        if (value.empty()) {
+            std::cerr << "Error: Empty value provided for argument: " << key << "\n\n";
+            usage(argv[0]);
+        }
+
+        if (key == "-p") {
+            portfolio = value;
+        } else if (key == "-s") {
+            schedule = value;
+        } else if (key == "-o") {
+            output = value;
+        } else if (key == "-b") {
+            base_ccy = value;
+        } else if (key == "-x") {
+            fixings_file = value;
+        } else if (key == "-n") {
+            TaskScheduler::set_global_threads(std::max(1, std::atoi(value.c_str())));
+        } else if (key == "-t") {
+            trace_file = value;
+            trace::enable();
+        } else {
+            std::cerr << "Error: Unknown argument: " << key << "\n\n";
+            usage(argv[0]);
+        }
+    }
+
+    if (portfolio.empty() || schedule.empty() || output.empty()) {
+        std::cerr << "Error: Missing required arguments.\n\n";
+        usage(argv[0]);
+    }
+
+    int rc = 0;
+    try {
+        size_t failed = run(portfolio, schedule, base_ccy, fixings_file, output);
+        if (failed > 0) {
+            std::cerr << failed << " valuation date(s) failed\n";
+            rc = -1; // the time series is incomplete
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        rc = -1; // report an error to the caller
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown exception occurred\n";
+        rc = -1; // report an error to the caller
+    }
+
+    // timeline of the run, showing how the valuation dates were spread over the workers
+    if (!trace_file.empty()) {
+        std::ofstream os(trace_file);
+        if (os.fail())
+            std::cerr << "Could not open file " << trace_file << "\n";
+        else
+            trace::write_json(os);
+    }
+
+    return rc;
+}
+
+// Under src folder: make
+// src/bin/DemoSweep.exe -p data/portfolio_10.txt -s data/sweep_schedule.txt -o sweep_10.txt -x data/fixings.txt
+// src/bin/DemoSweep.exe -p data/portfolio_10.txt -s data/sweep_schedule.txt -o sweep_10_gbp.txt -b GBP -x data/fixings.txt -n 4
@@ -0,0 +1,218 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+
+#include "Macros.h"
+#include "MarketDataServer.h"
+#include "PortfolioUtils.h"
+#include "FixingDataServer.h"
+#include "IncrementalRisk.h"
+
+using namespace::minirisk;
+
+// latency (in microseconds) below which the given fraction of the samples fall
+static double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t i = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size()))) ;
+    return sorted[std::min(sorted.size(), std::max<size_t>(i, 1)) - 1];
+}
+
+static void print_totals(const IncrementalRisk& risk)
+{
+    auto pv = risk.total();
+    std::cout << "PV" << separator << pv.first << separator << pv.second << "\n";
+    for (const auto& s : risk.sensitivities())
+        std::cout << s.first << separator << s.second.first << separator << s.second.second << "\n";
+}
+
+void run(const string& portfolio_file, const string& risk_factors_file, const string& ticks_file, const string& base_ccy, const string& fixings_file, bool verbose, bool check)
+{
+    portfolio_t portfolio = load_portfolio(portfolio_file);
+    std::vector<ppricer_t> pricers(get_pricers(portfolio, base_ccy));
+
+    std::shared_ptr<const MarketDataServer> mds(new MarketDataServer(risk_factors_file));
+    std::unique_ptr<FixingDataServer> fds;
+    if (!fixings_file.empty())
+        fds.reset(new FixingDataServer(fixings_file));
+
+    Date today(2017,8,5);
+    Market mkt(mds, today);
+
+    // cache all risk factors, so that any of them can tick
+    for (const auto& rf : mds->match(".+"))
+        mkt.get_value(rf, "risk factor");
+
+    IncrementalRisk risk(pricers, mkt, fds.get());
+
+    // tick file format: one update per line, made of one or more "<risk factor> <value>" pairs.
+    // Use "-" to read the ticks from stdin (e.g. from a pipe).
+    std::ifstream file;
+    if (ticks_file != "-") {
+        file.open(ticks_file);
+        MYASSERT(!file.fail(), "Could not open file " << ticks_file);
+    }
+    std::istream& is = (ticks_file == "-") ? std::cin : file;
+
+    std::cout << std::setprecision(17);
+
+    std::vector<double> latencies;
+    size_t repriced = 0;
+    for (string line; std::getline(is, line);) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        Market::vec_risk_factor_t ticks;
+        std::istringstream ls(line);
+        string name;
+        double value;
+        while (ls >> name >> value)
+            ticks.emplace_back(name, value);
+        MYASSERT(!ticks.empty(), "Invalid tick: " << line);
+
+        auto t0 = std::chrono::steady_clock::now();
+        repriced += risk.update(ticks);
+        auto t1 = std::chrono::steady_clock::now();
+        latencies.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+
+        if (verbose) {
+            auto pv = risk.total();
+            std::cout << latencies.size() << separator << pv.first << separator << pv.second << "\n";
+        }
+    }
+
+    std::cout << "Final totals:\n";
+    print_totals(risk);
+
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << std::setprecision(6)
+        << "\nUpdates: " << latencies.size() << ", trades repriced: " << repriced << " (portfolio size " << pricers.size() << ")\n"
+        << "Update latency (us): p50 " << percentile(latencies, 0.5)
+        << ", p90 " << percentile(latencies, 0.9)
+        << ", p99 " << percentile(latencies, 0.99)
+        << ", p99.9 " << percentile(latencies, 0.999)
+        << ", max " << (latencies.empty() ? 0.0 : latencies.back()) << "\n";
+
+    if (check) {
+        // compare with a full revaluation on a market rebuilt from the final risk factor values
+        Market full(mkt);
+        full.set_risk_factors(full.get_risk_factors(".+"));
+        auto prices = compute_prices(pricers, full, fds.get());
+        double max_diff = 0.0;
+        for (size_t i = 0; i < prices.size(); ++i) {
+            bool nan_full = std::isnan(prices[i].first), nan_incr = std::isnan(risk.prices()[i].first);
+            MYASSERT(nan_full == nan_incr, "Trade " << i << ": incremental and full revaluation disagree on errors");
+            if (!nan_full)
+                max_diff = std::max(max_diff, std::fabs(prices[i].first - risk.prices()[i].first));
+        }
+        max_diff = std::max(max_diff, std::fabs(portfolio_total(prices).first - risk.total().first));
+        std::vector<std::pair<string, portfolio_values_t>> sens(compute_pv01_bucketed(pricers, full, fds.get()));
+        auto fx = compute_fx_delta(pricers, full, fds.get());
+        sens.insert(sens.end(), fx.begin(), fx.end());
+        for (const auto& g : sens) {
+            auto it = risk.sensitivities().find(g.first);
+            double incr = (it == risk.sensitivities().end()) ? 0.0 : it->second.first;
+            max_diff = std::max(max_diff, std::fabs(portfolio_total(g.second).first - incr));
+        }
+        std::cout << "Check vs full revaluation: max abs difference " << max_diff << "\n";
+    }
+}
+
+void usage(const char* program_name)
+{
+    std::cerr
+        << "Usage: " << program_name << " -p <portfolio_file> -f <risk_factors_file> -t <ticks_file> [-b <base_currency>] [-x <fixings_file>] [-v 1] [-c 1]\n"
+        << "\n"
+        << "Replays a file of risk factor ticks, repricing incrementally after each tick, and\n"
+        << "reports final totals and update latency percentiles.\n"
+        << "\n"
+        << "Required arguments:\n"
+        << "  -p <portfolio_file>        Path to the portfolio file\n"
+        << "  -f <risk_factors_file>     Path to the initial risk factors file\n"
+        << "  -t <ticks_file>            Ticks, one update per line: <risk factor> <value> [...]\n"
+        << "                             Use - to read from stdin\n"
+        << "\n"
+        << "Optional arguments:\n"
+        << "  -b <base_currency>         Base currency (default: USD)\n"
+        << "  -x <fixings_file>          Path to the fixings file (optional)\n"
+        << "  -v 1                       Print the PV total after each update\n"
+        << "  -c 1                       Check final results against a full revaluation\n"
+        << "\n"
+        << "Example:\n"
+        << "  " << program_name << " -p data/portfolio_10.txt -f data/risk_factors_3.txt -t data/ticks_3.txt -x data/fixings.txt -c 1\n";
+    std::exit(1);
+}
+
+int main(int argc, const char **argv)
+{
+    // Handle no arguments case
+    if (argc == 1) {
+        usage(argv[0]);
+    }
+
+    string portfolio, riskfactors, ticks, fixings_file;
+    string base_ccy = "USD";
+    bool verbose = false, check = false;
+
+    // Validate argument count (must be odd: program name + pairs of key-value)
+    if (argc % 2 == 0) {
+        std::cerr << "Error: Invalid number of arguments.\n\n";
+        usage(argv[0]);
+    }
+
+    for (int i = 1; i < argc; i += 2) {
+        string key(argv[i]);
+        string value(argv[i+1]);
+
+        if (value.empty()) {
+            std::cerr << "Error: Empty value provided for argument: " << key << "\n\n";
+            usage(argv[0]);
+        }
+
+        if (key == "-p") {
+            portfolio = value;
+        } else if (key == "-f") {
+            riskfactors = value;
+        } else if (key == "-t") {
+            ticks = value;
+        } else if (key == "-b") {
+            base_ccy = value;
+        } else if (key == "-x") {
+            fixings_file = value;
+        } else if (key == "-v") {
+            verbose = value != "0";
+        } else if (key == "-c") {
+            check = value != "0";
+        } else {
+            std::cerr << "Error: Unknown argument: " << key << "\n\n";
+            usage(argv[0]);
+        }
+    }
+
+    if (portfolio.empty() || riskfactors.empty() || ticks.empty()) {
+        std::cerr << "Error: Missing required arguments.\n\n";
+        usage(argv[0]);
+    }
+
+    try {
+        run(portfolio, riskfactors, ticks, base_ccy, fixings_file, verbose, check);
+        return 0;  // report success to the caller
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return -1; // report an error to the caller
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown exception occurred\n";
+        return -1; // report an error to the caller
+    }
+}
+
+// Under src folder: make
+// src/bin/DemoTicks.exe -p data/portfolio_10.txt -f data/risk_factors_3.txt -t data/ticks_3.txt -x data/fixings.txt -c 1
+// cat data/ticks_3.txt | src/bin/DemoTicks.exe -p data/portfolio_10.txt -f data/risk_factors_3.txt -t - -x data/fixings.txt
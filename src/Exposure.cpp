@@ -0,0 +1,282 @@
+#include "Exposure.h"
+#include "CounterRng.h"
+#include "TradeFXForward.h"
+#include "CurveDiscount.h"
+#include "CurveFXSpot.h"
+#include "FixingDataServer.h"
+#include "TaskScheduler.h"
+#include "Reduction.h"
+#include "Global.h"
+#include "Trace.h"
+#include "Macros.h"
+
+#include <map>
+#include <cmath>
+#include <chrono>
+#include <numeric>
+#include <algorithm>
+
+namespace minirisk {
+
+namespace {
+
+// paths simulated by a task of the scheduler
+constexpr size_t path_grain = 64;
+
+// FX forward reduced to its coefficients in the simulated spots, see simulate_exposure
+struct fx_forward_t
+{
+    size_t index;           // in the portfolio
+    size_t netting_set;
+    unsigned ccy1, ccy2;    // simulated currencies
+    unsigned fix_step;      // first simulation date on or after fixing
+    unsigned settle_step;   // last simulation date on or before settlement
+    Date fixing_date, settle_date;
+    double a, b, c, A;      // N B2(T2) A, N B2(T2) K, N B2(T2), B1(T1) / B2(T1)
+    double fixing;          // fixed rate, when fixed before the first simulation date
+};
+
+// Trades by netting set, with coefficients in structure of arrays layout. Within a netting set
+// trades are sorted by decreasing settlement date, so that the trades alive at a simulation
+// date are a prefix of their netting set.
+struct fx_forwards_t
+{
+    explicit fx_forwards_t(std::vector<fx_forward_t>& trades, size_t n_netting_sets)
+        : begin(n_netting_sets + 1, 0)
+    {
+        std::stable_sort(trades.begin(), trades.end(), [](const fx_forward_t& x, const fx_forward_t& y) {
+            return x.netting_set != y.netting_set ? x.netting_set < y.netting_set : x.settle_step > y.settle_step;
+        });
+        for (const auto& t : trades) {
+            ++begin[t.netting_set + 1];
+            ccy1.push_back(t.ccy1);
+            ccy2.push_back(t.ccy2);
+            fix_step.push_back(t.fix_step);
+            settle_step.push_back(t.settle_step);
+            a.push_back(t.a);
+            b.push_back(t.b);
+            c.push_back(t.c);
+            A.push_back(t.A);
+            fixing.push_back(t.fixing);
+        }
+        std::partial_sum(begin.begin(), begin.end(), begin.begin());
+    }
+
+    size_t size() const { return a.size(); }
+
+    std::vector<size_t> begin;      // first trade of each netting set, and the number of trades
+    std::vector<unsigned> ccy1, ccy2, fix_step, settle_step;
+    std::vector<double> a, b, c, A, fixing;
+};
+
+} // namespace
+
+exposure_result_t simulate_exposure(const portfolio_t& portfolio, const Market& mkt, const FixingDataServer* fds, const string& base_ccy
+    , const std::vector<string>& netting_sets, const exposure_settings_t& settings)
+{
+    trace::ScopedEvent event("simulate_exposure", "exposure");
+
+    MYASSERT(netting_sets.empty() || netting_sets.size() == portfolio.size(),
+        "Got " << netting_sets.size() << " netting sets for " << portfolio.size() << " trades");
+    MYASSERT(settings.n_paths > 0, "The number of paths must be positive");
+    MYASSERT(settings.step_days > 0, "The simulation step must be positive");
+    MYASSERT(std::isfinite(settings.fx_vol) && settings.fx_vol >= 0.0, "Invalid FX volatility: " << settings.fx_vol);
+    MYASSERT(settings.pfe_quantile > 0.0 && settings.pfe_quantile < 1.0, "The PFE quantile must be in (0, 1), got: " << settings.pfe_quantile);
+
+    const Date today = mkt.today();
+    const Ccy base(base_ccy);
+    const Ccy usd("USD");
+
+    exposure_result_t res;
+    res.trades = 0;
+    res.skipped = 0;
+    res.paths = settings.n_paths;
+
+    // Simulated currencies, the first being USD whose spot is 1. X0 are the spots in USD per
+    // unit of currency.
+    std::vector<Ccy> ccys(1, usd);
+    std::vector<double> X0(1, 1.0);
+    auto ccy_index = [&](Ccy ccy) {
+        auto it = std::find(ccys.begin(), ccys.end(), ccy);
+        if (it != ccys.end())
+            return static_cast<unsigned>(it - ccys.begin());
+        X0.push_back(mkt.get_fx_spot_curve(fx_spot_name(ccy, usd))->spot());
+        ccys.push_back(ccy);
+        return static_cast<unsigned>(ccys.size() - 1);
+    };
+    const unsigned base_index = ccy_index(base);
+    const ptr_disc_curve_t base_disc = mkt.get_discount_curve(ir_curve_discount_name(base));
+
+    // Coefficients of the trades, whose simulation steps are set once the grid is known
+    std::map<string, size_t> netting_set_index;
+    std::vector<fx_forward_t> trades;
+    Date last_date = today;
+    for (size_t i = 0; i < portfolio.size(); ++i) {
+        if (portfolio[i]->id() != TradeFXForward::m_id) {
+            ++res.skipped;
+            continue;
+        }
+        const TradeFXForward& trd = static_cast<const TradeFXForward&>(*portfolio[i]);
+        try {
+            const Date T1 = trd.fixing_date();
+            const Date T2 = trd.settle_date();
+            MYASSERT(!(T2 < today), "Trade is expired: settlement date " << T2.to_string()
+                    << " is before pricing date " << today.to_string());
+
+            fx_forward_t t;
+            t.index = i;
+            t.fixing_date = T1;
+            t.settle_date = T2;
+            t.ccy1 = ccy_index(trd.ccy1());
+            t.ccy2 = ccy_index(trd.ccy2());
+            t.c = trd.quantity() * mkt.get_discount_curve(ir_curve_discount_name(trd.ccy2()))->df(T2);
+            t.a = 0.0;
+            t.b = t.c * trd.strike();
+            base_disc->df(T2);  // the base curve must cover the life of the trade
+
+            // the forward of the fixing date, or the rate it fixed at
+            const double forward = X0[t.ccy1] / X0[t.ccy2];
+            if (today < T1) {
+                t.A = mkt.get_discount_curve(ir_curve_discount_name(trd.ccy1()))->df(T1)
+                    / mkt.get_discount_curve(ir_curve_discount_name(trd.ccy2()))->df(T1);
+                t.a = t.c * t.A;
+                t.fixing = 0.0;
+            }
+            else {
+                t.A = 0.0;
+                const string name = fx_spot_name(trd.ccy1(), trd.ccy2());
+                MYASSERT(fds || T1 == today, "Historical fixing required for date " << T1.to_string()
+                        << " but no fixing data server provided");
+                if (T1 == today) {
+                    auto fixing = fds ? fds->lookup(name, T1) : std::make_pair(0.0, false);
+                    t.fixing = fixing.second ? fixing.first : forward;
+                }
+                else {
+                    t.fixing = fds->get(name, T1);
+                }
+            }
+
+            const string& ns = netting_sets.empty() ? string("ALL") : netting_sets[i];
+            t.netting_set = netting_set_index.emplace(ns, netting_set_index.size()).first->second;
+            trades.push_back(t);
+            last_date = std::max(last_date, T2);
+        }
+        catch (const std::exception& e) {
+            res.errors.emplace_back(i, e.what());
+        }
+    }
+    res.trades = trades.size();
+
+    // Simulation dates: today, then every step_days days until the last settlement
+    for (unsigned d = today.serial(); d <= last_date.serial(); d += settings.step_days)
+        res.dates.emplace_back(d);
+    const size_t n_dates = res.dates.size();
+
+    std::vector<double> inv_base_df(n_dates), drift(n_dates, 0.0), diffusion(n_dates, 0.0);
+    for (size_t k = 0; k < n_dates; ++k) {
+        inv_base_df[k] = 1.0 / base_disc->df(res.dates[k]);
+        if (k > 0) {
+            const double dt = time_frac(res.dates[k - 1], res.dates[k]);
+            drift[k] = -0.5 * settings.fx_vol * settings.fx_vol * dt;
+            diffusion[k] = settings.fx_vol * std::sqrt(dt);
+        }
+    }
+
+    for (auto& t : trades) {
+        const unsigned T1 = t.fixing_date.serial();
+        const unsigned T2 = t.settle_date.serial();
+        t.fix_step = T1 <= today.serial() ? 0 : (T1 - today.serial() + settings.step_days - 1) / settings.step_days;
+        t.settle_step = (T2 - today.serial()) / settings.step_days;
+    }
+
+    // netting sets in name order
+    std::vector<size_t> ns_order(netting_set_index.size());
+    for (const auto& ns : netting_set_index) {
+        ns_order[ns.second] = res.profiles.size();
+        res.profiles.emplace_back();
+        res.profiles.back().netting_set = ns.first;
+    }
+    for (auto& t : trades)
+        t.netting_set = ns_order[t.netting_set];
+    const size_t n_sets = res.profiles.size();
+
+    const fx_forwards_t fx(trades, n_sets);
+    const size_t n_ccys = ccys.size();
+    const size_t n_paths = settings.n_paths;
+    const CounterRng rng(settings.seed);
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    // values of the netting sets, by date and netting set, then path
+    std::vector<double> V(n_dates * n_sets * n_paths);
+
+    TaskScheduler::global().parallel_for(n_paths, path_grain, [&](unsigned, size_t pbegin, size_t pend) {
+        std::vector<double> Z(n_ccys), F(fx.size());
+        for (size_t p = pbegin; p < pend; ++p) {
+            std::copy(X0.begin(), X0.end(), Z.begin());
+            std::copy(fx.fixing.begin(), fx.fixing.end(), F.begin());
+            for (size_t k = 0; k < n_dates; ++k) {
+                // spots of the currencies other than USD, with one counter per pair of them
+                if (k > 0) {
+                    for (size_t i = 1; i < n_ccys; i += 2) {
+                        double z0, z1;
+                        rng.normals({ static_cast<uint32_t>(p), static_cast<uint32_t>(uint64_t(p) >> 32), static_cast<uint32_t>(k), static_cast<uint32_t>(i / 2) }, z0, z1);
+                        Z[i] *= std::exp(drift[k] + diffusion[k] * z0);
+                        if (i + 1 < n_ccys)
+                            Z[i + 1] *= std::exp(drift[k] + diffusion[k] * z1);
+                    }
+                }
+
+                const double scale = inv_base_df[k] / Z[base_index];
+                for (size_t s = 0; s < n_sets; ++s) {
+                    double v = 0.0;
+                    for (size_t j = fx.begin[s]; j < fx.begin[s + 1] && fx.settle_step[j] >= k; ++j) {
+                        const double z1 = Z[fx.ccy1[j]];
+                        const double z2 = Z[fx.ccy2[j]];
+                        if (k < fx.fix_step[j]) {
+                            v += fx.a[j] * z1 - fx.b[j] * z2;
+                            if (k + 1 == fx.fix_step[j])
+                                F[j] = fx.A[j] * z1 / z2;
+                        }
+                        else {
+                            v += (fx.c[j] * F[j] - fx.b[j]) * z2;
+                        }
+                    }
+                    V[(k * n_sets + s) * n_paths + p] = v * scale;
+                }
+            }
+        }
+    });
+
+    // statistics of each date and netting set over the paths
+    const size_t q = static_cast<size_t>(std::ceil(settings.pfe_quantile * n_paths)) - 1;
+    for (auto& prof : res.profiles) {
+        prof.epe.resize(n_dates);
+        prof.pfe.resize(n_dates);
+        prof.mean.resize(n_dates);
+    }
+    TaskScheduler::global().parallel_for(n_dates * n_sets, 1, [&](unsigned, size_t begin, size_t end) {
+        std::vector<double> positive(n_paths);
+        for (size_t ks = begin; ks < end; ++ks) {
+            const double* v = &V[ks * n_paths];
+            ReproducibleSum mean, epe;
+            for (size_t p = 0; p < n_paths; ++p) {
+                positive[p] = std::max(v[p], 0.0);
+                mean.add(v[p]);
+                epe.add(positive[p]);
+            }
+            std::nth_element(positive.begin(), positive.begin() + q, positive.end());
+            exposure_profile_t& prof = res.profiles[ks % n_sets];
+            const size_t k = ks / n_sets;
+            prof.mean[k] = mean.value() / n_paths;
+            prof.epe[k] = epe.value() / n_paths;
+            prof.pfe[k] = positive[q];
+        }
+    });
+
+    res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    return res;
+}
+
+} // namespace minirisk
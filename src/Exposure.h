@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+
+#include "PortfolioUtils.h"
+#include "Market.h"
+
+namespace minirisk {
+
+// Settings of a Monte Carlo exposure simulation
+struct exposure_settings_t
+{
+    size_t n_paths = 10000;
+    unsigned step_days = 30;        // spacing of the simulation dates
+    double fx_vol = 0.10;           // lognormal volatility of the FX spots against USD
+    double pfe_quantile = 0.975;
+    uint64_t seed = 1;
+};
+
+// Exposure profile of a netting set, one value per simulation date
+struct exposure_profile_t
+{
+    string netting_set;
+    std::vector<double> epe;        // expected positive exposure, E[max(V, 0)]
+    std::vector<double> pfe;        // potential future exposure, quantile of max(V, 0)
+    std::vector<double> mean;       // expected value E[V]
+};
+
+// Results of an exposure simulation
+struct exposure_result_t
+{
+    std::vector<Date> dates;                    // simulation dates, starting today
+    std::vector<exposure_profile_t> profiles;   // by netting set name
+
+    size_t trades;                              // FX forwards simulated
+    size_t skipped;                             // trades of other types
+    std::vector<std::pair<size_t, string>> errors;  // FX forwards which cannot be simulated
+
+    size_t paths;
+    double seconds;                             // simulation time
+
+    double path_dates_per_second() const { return seconds > 0.0 ? paths * dates.size() / seconds : 0.0; }
+};
+
+// Simulate the exposure in base_ccy of the FX forwards of a portfolio, by netting set
+// (netting_sets gives the netting set of each trade, or is empty for a single one).
+//
+// The FX spots against USD follow independent lognormal martingales around their forwards,
+// whose drift comes from the discount curves of mkt, and rates are deterministic. The value of
+// a forward in base currency is then linear in the simulated spots, with coefficients computed
+// once per trade from the curves: trades are grouped by netting set in a structure of arrays,
+// and each path date is a loop over contiguous coefficients rather than a call to the pricer.
+// The rate a trade fixes at is its forward on the last simulation date before fixing.
+//
+// Normal draws are numbered by (path, date, currency) with a counter-based generator, and the
+// paths are simulated in blocks on the global scheduler: results only depend on the seed.
+exposure_result_t simulate_exposure(const portfolio_t& portfolio, const Market& mkt, const FixingDataServer* fds, const string& base_ccy
+    , const std::vector<string>& netting_sets, const exposure_settings_t& settings = exposure_settings_t());
+
+} // namespace minirisk
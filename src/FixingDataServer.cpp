@@ -9,10 +9,13 @@ namespace minirisk {
 
 static unsigned parse_yyyymmdd(const string& s)
 {
-    MYASSERT(s.size() == 8, "Invalid date format (expected YYYYMMDD): " << s);
-    unsigned y = std::stoul(s.substr(0,4));
-    unsigned m = std::stoul(s.substr(4,2));
-    unsigned d = std::stoul(s.substr(6,2));
+    MYASSERT(s.size() == Date::YYYYMMDD_SIZE, "Invalid date format (expected YYYYMMDD): " << s);
+    unsigned y, m, d;
+    if (Date::parse_yyyymmdd(s.data(), y, m, d))
+        return Date::calendar_to_serial(y,m,d);
+    y = std::stoul(s.substr(0,4));
+    m = std::stoul(s.substr(4,2));
+    d = std::stoul(s.substr(6,2));
     return Date::calendar_to_serial(y,m,d);
 }
 
@@ -3,6 +3,8 @@
 #include <cstddef>
 #include <string>
 
+#include "Ccy.h"
+
 using std::string;
 using std::size_t;
 
@@ -13,19 +15,31 @@ extern const string ir_curve_discount_prefix;
 extern const string fx_spot_prefix;
 extern const string fx_fwd_prefix;
 
-inline string ir_curve_discount_name(const string& ccy)
+// The names built from currency codes fit in the small string buffer, so they do not allocate.
+
+inline string ir_curve_discount_name(Ccy ccy)
 {
-    return ir_curve_discount_prefix + ccy;
+    string name(ir_curve_discount_prefix);
+    ccy.append_to(name);
+    return name;
 }
 
-inline string fx_spot_name(const string& ccy1, const string& ccy2)
+inline string fx_spot_name(Ccy ccy1, Ccy ccy2)
 {
-    return fx_spot_prefix + ccy1 + "." + ccy2;
+    string name(fx_spot_prefix);
+    ccy1.append_to(name);
+    name += '.';
+    ccy2.append_to(name);
+    return name;
 }
 
-inline string fx_fwd_name(const string& ccy1, const string& ccy2)
+inline string fx_fwd_name(Ccy ccy1, Ccy ccy2)
 {
-    return fx_fwd_prefix + ccy1 + "." + ccy2;
+    string name(fx_fwd_prefix);
+    ccy1.append_to(name);
+    name += '.';
+    ccy2.append_to(name);
+    return name;
 }
 
 string format_label(const string& s);
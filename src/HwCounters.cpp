@@ -0,0 +1,148 @@
+#include "HwCounters.h"
+
+#include <cstring>
+#include <cerrno>
+#include <mutex>
+#include <memory>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace minirisk {
+namespace perf {
+
+const char* const hw_counter_names[n_hw_counters] = {
+    "cycles",
+    "instructions",
+    "llc_misses",
+    "branch_misses"
+};
+
+#ifdef __linux__
+
+static int open_counter(uint64_t config, int group_fd)
+{
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = (group_fd == -1);  // the group starts when the leader is enabled
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(::syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+HwCounters::HwCounters()
+{
+    static const uint64_t configs[n_hw_counters] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    for (auto& fd : m_fd)
+        fd = -1;
+
+    m_fd[hw_cycles] = open_counter(configs[hw_cycles], -1);
+    if (m_fd[hw_cycles] < 0) {
+        m_status = string("perf_event_open failed: ") + std::strerror(errno);
+        return;
+    }
+
+    for (size_t i = 1; i < n_hw_counters; ++i) {
+        m_fd[i] = open_counter(configs[i], m_fd[hw_cycles]);
+        if (m_fd[i] < 0)
+            m_status += (m_status.empty() ? "not supported:" : "") + string(" ") + hw_counter_names[i];
+    }
+
+    ::ioctl(m_fd[hw_cycles], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ::ioctl(m_fd[hw_cycles], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+HwCounters::~HwCounters()
+{
+    for (int fd : m_fd)
+        if (fd >= 0)
+            ::close(fd);
+}
+
+HwCounters::sample_t HwCounters::read() const
+{
+    sample_t s;
+    for (size_t i = 0; i < n_hw_counters; ++i) {
+        s.values[i] = available() ? -1 : 0;
+        if (m_fd[i] < 0)
+            continue;
+        // value, time enabled, time running
+        uint64_t buf[3];
+        if (::read(m_fd[i], buf, sizeof(buf)) != sizeof(buf))
+            continue;
+        double scale = (buf[2] > 0 && buf[2] < buf[1]) ? static_cast<double>(buf[1]) / static_cast<double>(buf[2]) : 1.0;
+        s.values[i] = static_cast<int64_t>(static_cast<double>(buf[0]) * scale);
+    }
+    return s;
+}
+
+#else
+
+HwCounters::HwCounters()
+    : m_status("hardware counters are only supported on Linux")
+{
+    for (auto& fd : m_fd)
+        fd = -1;
+}
+
+HwCounters::~HwCounters()
+{
+}
+
+HwCounters::sample_t HwCounters::read() const
+{
+    sample_t s;
+    for (auto& v : s.values)
+        v = 0;
+    return s;
+}
+
+#endif
+
+// Counters of the threads which opened them. They are registered once per thread and live
+// until the end of the process: a counter of a finished thread still reads its final count.
+static std::mutex registry_mutex;
+static std::vector<std::unique_ptr<HwCounters>> registry;
+
+const HwCounters& this_thread_hw_counters()
+{
+    thread_local HwCounters* counters = nullptr;
+    if (!counters) {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.emplace_back(new HwCounters);
+        counters = registry.back().get();
+    }
+    return *counters;
+}
+
+HwCounters::sample_t all_threads_hw_counters()
+{
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    HwCounters::sample_t sum = {};
+    for (const auto& c : registry) {
+        if (!c->available())
+            continue;
+        const HwCounters::sample_t s = c->read();
+        for (size_t i = 0; i < n_hw_counters; ++i)
+            sum.values[i] = (sum.values[i] < 0 || s.values[i] < 0) ? -1 : sum.values[i] + s.values[i];
+    }
+    return sum;
+}
+
+} // namespace perf
+} // namespace minirisk
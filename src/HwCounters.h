@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Global.h"
+
+namespace minirisk {
+
+namespace perf {
+
+enum hw_counter_t
+{
+    hw_cycles,
+    hw_instructions,
+    hw_llc_misses,          // last level cache misses
+    hw_branch_misses,
+    n_hw_counters
+};
+
+extern const char* const hw_counter_names[n_hw_counters];
+
+// Hardware performance counters of the calling thread (user space only), opened as one
+// perf_event_open group so that they are scheduled together.
+// If the kernel denies access (see /proc/sys/kernel/perf_event_paranoid), or the platform
+// has no PMU, the object is still usable: available() is false and all counts read as zero.
+// A single counter not supported by the CPU (e.g. LLC misses in some VMs) reads as -1.
+struct HwCounters
+{
+    struct sample_t
+    {
+        int64_t values[n_hw_counters];
+    };
+
+    HwCounters();
+    ~HwCounters();
+
+    HwCounters(const HwCounters&) = delete;
+    HwCounters& operator=(const HwCounters&) = delete;
+
+    bool available() const { return m_fd[hw_cycles] >= 0; }
+
+    // why the counters are not available, or the list of missing counters
+    const string& status() const { return m_status; }
+
+    // current counts since the group was opened, scaled if the kernel had to multiplex
+    sample_t read() const;
+
+private:
+    int m_fd[n_hw_counters];
+    string m_status;
+};
+
+// counters of the calling thread, opened on first use
+const HwCounters& this_thread_hw_counters();
+
+// Sum of the counters of all the threads which opened them with this_thread_hw_counters(),
+// including those which have finished since. A counter is -1 if it is not supported by one of
+// the threads. Differences of two sums count the work of every thread in between, e.g. of
+// the TaskScheduler threads, which open their counters when they start running a loop.
+HwCounters::sample_t all_threads_hw_counters();
+
+} // namespace perf
+
+} // namespace minirisk
@@ -11,6 +11,9 @@ namespace minirisk {
 struct IPricer : IObject
 {
     virtual double price(Market& m, const FixingDataServer* fds = nullptr) const = 0;
+
+    // currency in which the price is expressed
+    virtual Ccy ccy() const = 0;
 };
 
 typedef std::shared_ptr<const IPricer> ppricer_t;
@@ -9,6 +9,8 @@
 
 namespace minirisk {
 
+struct ReportWriter;
+
 // NOTE: in a real world system this should be a proper serializable guid class
 typedef unsigned guid_t;
 
@@ -29,8 +31,10 @@ struct ITrade : IObject
 
     // print trade attributes
     virtual void print(std::ostream& os) const = 0;
+    virtual void print(ReportWriter& w) const = 0;
 
     // Get pricer with configuration (e.g. base currency)
+    // An empty configuration prices the trade in its own settlement currency
     virtual ppricer_t pricer(const std::string& configuration) const = 0;
 };
 
@@ -0,0 +1,261 @@
+#include "IncrementalRisk.h"
+#include "Macros.h"
+#include "PerfCounters.h"
+#include "Reduction.h"
+
+#include <cmath>
+#include <limits>
+
+namespace minirisk {
+
+IncrementalRisk::IncrementalRisk(const std::vector<ppricer_t>& pricers, Market& mkt, const FixingDataServer* fds)
+    : m_pricers(pricers)
+    , m_mkt(mkt)
+    , m_fds(fds)
+    , m_prices(pricers.size(), std::make_pair(std::numeric_limits<double>::quiet_NaN(), string()))
+    , m_deps(pricers.size())
+    , m_sens(pricers.size())
+    , m_errors(0)
+{
+    for (size_t i = 0; i < pricers.size(); ++i)
+        MYASSERT(pricers[i].get() != nullptr, "Pricer at index " << i << " is null");
+
+    std::set<size_t> all;
+    for (size_t i = 0; i < pricers.size(); ++i)
+        all.insert(all.end(), i);
+    reprice(all);
+}
+
+size_t IncrementalRisk::update(const Market::vec_risk_factor_t& risk_factors)
+{
+    m_mkt.update_risk_factors(risk_factors);
+
+    std::set<size_t> affected;
+    for (const auto& rf : risk_factors) {
+        auto it = m_dependents.find(rf.first);
+        if (it != m_dependents.end())
+            affected.insert(it->second.begin(), it->second.end());
+    }
+    reprice(affected);
+    return affected.size();
+}
+
+size_t IncrementalRisk::add(const ppricer_t& pricer)
+{
+    MYASSERT(pricer.get() != nullptr, "Cannot add a null pricer");
+    size_t slot;
+    if (m_free.empty()) {
+        slot = m_pricers.size();
+        m_pricers.push_back(pricer);
+        m_prices.emplace_back(std::numeric_limits<double>::quiet_NaN(), string());
+        m_deps.emplace_back();
+        m_sens.emplace_back();
+    } else {
+        slot = m_free.back();
+        m_free.pop_back();
+        m_pricers[slot] = pricer;
+    }
+    reprice(std::set<size_t>{ slot });
+    return slot;
+}
+
+void IncrementalRisk::replace(size_t slot, const ppricer_t& pricer)
+{
+    MYASSERT(slot < m_pricers.size() && m_pricers[slot], "No trade in slot " << slot);
+    MYASSERT(pricer.get() != nullptr, "Cannot replace with a null pricer");
+    m_pricers[slot] = pricer;
+    reprice(std::set<size_t>{ slot });
+}
+
+void IncrementalRisk::remove(size_t slot)
+{
+    MYASSERT(slot < m_pricers.size() && m_pricers[slot], "No trade in slot " << slot);
+    subtract(slot);
+    m_pricers[slot].reset();
+    m_prices[slot] = std::make_pair(std::numeric_limits<double>::quiet_NaN(), string());
+    m_free.push_back(slot);
+    refresh();
+}
+
+// Bumped values and finite difference denominator for a risk factor, computed exactly as in
+// compute_pv01_bucketed (IR rates) and compute_fx_delta (FX spots) with the default settings.
+// Returns false for risk factors without sensitivity.
+static bool bump_scenario(const string& name, double value, double& dn, double& up, double& denom)
+{
+    const bump_settings_t bumps;
+    if (name.compare(0, fx_spot_prefix.size(), fx_spot_prefix) == 0) {
+        const double rel_bump = bumps.fx_rel_bump;
+        dn = value * (1.0 - rel_bump);
+        up = value * (1.0 + rel_bump);
+        denom = 2.0 * value * rel_bump;
+        return true;
+    }
+    if (name.compare(0, ir_rate_prefix.size(), ir_rate_prefix) == 0) {
+        const double bump_size = bumps.ir_bump;
+        dn = value - bump_size;
+        up = value + bump_size;
+        denom = 2.0 * bump_size;
+        return true;
+    }
+    return false;
+}
+
+void IncrementalRisk::invalidate(size_t slot)
+{
+    const size_t leaf = slot / ReproducibleSumTree::leaf_size;
+    m_dirty_total.insert(leaf);
+    for (const auto& d : m_deps[slot])
+        m_dirty_sens[d].insert(leaf);
+}
+
+void IncrementalRisk::refresh()
+{
+    const size_t leaf_size = ReproducibleSumTree::leaf_size;
+    const size_t n = m_prices.size();
+
+    if (m_total.size() != n)
+        m_total.resize(n);
+    for (size_t l : m_dirty_total) {
+        ReproducibleSum s;
+        for (size_t i = l * leaf_size; i < std::min(n, (l + 1) * leaf_size); ++i) {
+            if (std::isnan(m_prices[i].first))
+                s.skip();
+            else
+                s.add(m_prices[i].first);
+        }
+        m_total.set_leaf(l, s.value());
+    }
+    m_dirty_total.clear();
+
+    // the leaves of a sensitivity only have the slots depending on the risk factor
+    for (const auto& dirty : m_dirty_sens) {
+        const string& name = dirty.first;
+        auto t = m_sens_totals.find(name);
+        if (t == m_sens_totals.end())
+            continue;
+        const std::set<size_t>& dependents = m_dependents.find(name)->second;
+        ReproducibleSumTree& tree = m_sens_trees[name];
+        if (tree.size() != n)
+            tree.resize(n);
+        for (size_t l : dirty.second) {
+            ReproducibleSum s;
+            size_t pos = l * leaf_size;
+            for (auto it = dependents.lower_bound(pos); it != dependents.end() && *it < (l + 1) * leaf_size; ++it) {
+                auto v = m_sens[*it].find(name);
+                if (v == m_sens[*it].end())
+                    continue;
+                s.skip(*it - pos);
+                if (std::isnan(v->second.first))
+                    s.skip();
+                else
+                    s.add(v->second.first);
+                pos = *it + 1;
+            }
+            tree.set_leaf(l, s.value());
+        }
+        t->second.first = tree.value();
+    }
+    m_dirty_sens.clear();
+}
+
+void IncrementalRisk::subtract(size_t slot)
+{
+    invalidate(slot);
+    if (std::isnan(m_prices[slot].first) && !m_prices[slot].second.empty())
+        --m_errors;  // unpriced slots have no error message and are not counted
+
+    for (const auto& s : m_sens[slot]) {
+        if (std::isnan(s.second.first))
+            --m_sens_totals.find(s.first)->second.second;
+    }
+    m_sens[slot].clear();
+
+    for (const auto& d : m_deps[slot]) {
+        auto dep = m_dependents.find(d);
+        dep->second.erase(slot);
+        if (dep->second.empty()) {
+            m_sens_totals.erase(d);
+            m_sens_trees.erase(d);
+            m_dependents.erase(dep);
+        }
+    }
+    m_deps[slot].clear();
+}
+
+void IncrementalRisk::reprice(const std::set<size_t>& trades)
+{
+    // risk factors of the repriced trades
+    std::set<string> touched;
+
+    // reprice, recording the dependencies of each trade
+    for (size_t i : trades) {
+        subtract(i);
+
+        std::pair<double, string> price;
+        m_mkt.record_dependencies(&m_deps[i]);
+        perf::count(perf::pricing_calls);
+        try {
+            price = std::make_pair(m_pricers[i]->price(m_mkt, m_fds), string());
+        } catch (const std::exception& e) {
+            perf::count(perf::pricing_errors);
+            price = std::make_pair(std::numeric_limits<double>::quiet_NaN(), e.what());
+        }
+        m_mkt.record_dependencies(nullptr);
+
+        if (std::isnan(price.first))
+            ++m_errors;
+        m_prices[i] = price;
+        invalidate(i);
+
+        for (const auto& d : m_deps[i]) {
+            m_dependents[d].insert(i);
+            touched.insert(d);
+        }
+    }
+
+    // bump each risk factor once, repricing only the given trades depending on it
+    for (const string& name : touched) {
+        double value = m_mkt.get_value(name, "risk factor");
+        double dn, up, denom;
+        if (!bump_scenario(name, value, dn, up, denom))
+            continue;
+
+        std::vector<size_t> bumped_trades;
+        for (size_t i : m_dependents[name])
+            if (trades.count(i))
+                bumped_trades.push_back(i);
+
+        auto price_all = [&](double bumped) {
+            m_mkt.update_risk_factors(Market::vec_risk_factor_t(1, std::make_pair(name, bumped)));
+            portfolio_values_t pv(bumped_trades.size());
+            perf::count(perf::pricing_calls, bumped_trades.size());
+            for (size_t k = 0; k < bumped_trades.size(); ++k) {
+                try {
+                    pv[k] = std::make_pair(m_pricers[bumped_trades[k]]->price(m_mkt, m_fds), string());
+                } catch (const std::exception& e) {
+                    perf::count(perf::pricing_errors);
+                    pv[k] = std::make_pair(std::numeric_limits<double>::quiet_NaN(), e.what());
+                }
+            }
+            return pv;
+        };
+        auto pv_dn = price_all(dn);
+        auto pv_up = price_all(up);
+        m_mkt.update_risk_factors(Market::vec_risk_factor_t(1, std::make_pair(name, value)));
+
+        total_t& t = m_sens_totals[name];
+        for (size_t k = 0; k < bumped_trades.size(); ++k) {
+            auto& s = m_sens[bumped_trades[k]][name];
+            if (std::isnan(pv_up[k].first) || std::isnan(pv_dn[k].first))
+                s = std::make_pair(std::numeric_limits<double>::quiet_NaN(), std::isnan(pv_up[k].first) ? pv_up[k].second : pv_dn[k].second);
+            else
+                s = std::make_pair((pv_up[k].first - pv_dn[k].first) / denom, string());
+            if (std::isnan(s.first))
+                ++t.second;
+        }
+    }
+
+    refresh();
+}
+
+} // namespace minirisk
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <map>
+#include <set>
+
+#include "PortfolioUtils.h"
+#include "Market.h"
+#include "Reduction.h"
+
+namespace minirisk {
+
+// Keeps prices and sensitivities of a set of trades up to date as risk factors and trades
+// change. While pricing, the engine records which risk factors each trade depends on
+// (directly or through the curves it uses), so that a market update only rebuilds the
+// affected curves and reprices the affected trades, and a trade change only prices that trade.
+//
+// Sensitivities are computed per trade with respect to each of its risk factors, with
+// the same bumps as compute_pv01_bucketed (IR rates) and compute_fx_delta (FX spots).
+// Totals are ReproducibleSums over the slots in order, as portfolio_total computes for a full
+// revaluation, so they do not depend on the order of the updates. They are kept in
+// ReproducibleSumTrees: an update only sums again the leaves of slots it repriced.
+struct IncrementalRisk
+{
+    // (total, number of trades in error)
+    typedef std::pair<double, size_t> total_t;
+
+    // prices all the pricers; all risk factors that may be updated must be cached in mkt
+    IncrementalRisk(const std::vector<ppricer_t>& pricers, Market& mkt, const FixingDataServer* fds);
+
+    // apply the new risk factor values and reprice the dependent trades.
+    // Returns the number of trades repriced.
+    size_t update(const Market::vec_risk_factor_t& risk_factors);
+
+    // add a trade, returning its slot (slots of removed trades are reused)
+    size_t add(const ppricer_t& pricer);
+
+    // replace the trade in a slot
+    void replace(size_t slot, const ppricer_t& pricer);
+
+    // remove the trade in a slot
+    void remove(size_t slot);
+
+    // per slot prices (removed slots have a NaN price and an empty message)
+    const portfolio_values_t& prices() const { return m_prices; }
+
+    // per risk factor sensitivities of the trade in a slot
+    const std::map<string, std::pair<double, string>>& sensitivities(size_t slot) const { return m_sens[slot]; }
+
+    // portfolio PV
+    total_t total() const { return total_t(m_total.value(), m_errors); }
+
+    // sensitivity totals per risk factor, over the trades depending on it
+    const std::map<string, total_t>& sensitivities() const { return m_sens_totals; }
+
+private:
+    // reprice the given trades and their sensitivities, and refresh the totals
+    void reprice(const std::set<size_t>& trades);
+
+    // remove from the totals the contributions of a trade
+    void subtract(size_t slot);
+
+    // mark the leaves of the totals depending on a trade as to be summed again
+    void invalidate(size_t slot);
+
+    // sum again the marked leaves, and update the totals
+    void refresh();
+
+    std::vector<ppricer_t> m_pricers;
+    Market& m_mkt;
+    const FixingDataServer* m_fds;
+
+    // per trade price, risk factors and sensitivities
+    portfolio_values_t m_prices;
+    std::vector<std::set<string>> m_deps;
+    std::vector<std::map<string, std::pair<double, string>>> m_sens;
+
+    // slots of removed trades
+    std::vector<size_t> m_free;
+
+    // trades depending on each risk factor
+    std::map<string, std::set<size_t>> m_dependents;
+
+    // totals, with the leaves to sum again after an update
+    ReproducibleSumTree m_total;
+    size_t m_errors;
+    std::map<string, total_t> m_sens_totals;
+    std::map<string, ReproducibleSumTree> m_sens_trees;
+    std::set<size_t> m_dirty_total;
+    std::map<string, std::set<size_t>> m_dirty_sens;
+};
+
+} // namespace minirisk
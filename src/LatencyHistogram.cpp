@@ -0,0 +1,156 @@
+#include "LatencyHistogram.h"
+#include "Streamer.h"
+
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <iomanip>
+#include <cmath>
+
+namespace minirisk {
+namespace perf {
+
+std::atomic<bool> g_latency_enabled(false);
+
+static const char* const latency_names[n_latencies] = {
+    "pricer.PricerPayment",
+    "pricer.PricerFXForward",
+    "compute_prices",
+    "curve.CurveDiscount",
+    "curve.CurveFXForward"
+};
+
+void LatencyHistogram::merge(const LatencyHistogram& h)
+{
+    for (unsigned i = 0; i < n_buckets; ++i) {
+        uint64_t n = h.m_counts[i].load(std::memory_order_relaxed);
+        if (n)
+            m_counts[i].store(m_counts[i].load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+    if (h.max() > max())
+        m_max.store(h.max(), std::memory_order_relaxed);
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto& c : m_counts)
+        c.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::count() const
+{
+    uint64_t n = 0;
+    for (const auto& c : m_counts)
+        n += c.load(std::memory_order_relaxed);
+    return n;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const
+{
+    uint64_t n = count();
+    if (n == 0)
+        return 0;
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p * static_cast<double>(n))));
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < n_buckets; ++i) {
+        seen += m_counts[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+            return std::min(bucket_upper(i), max());
+    }
+    return max();
+}
+
+// Histograms of one thread. They are registered once per thread and live until the end of
+// the process, so that the samples of finished threads are kept.
+struct thread_histograms_t
+{
+    LatencyHistogram h[n_latencies];
+};
+
+static std::mutex registry_mutex;
+static std::vector<std::unique_ptr<thread_histograms_t>> registry;
+
+static thread_histograms_t& this_thread_histograms()
+{
+    thread_local thread_histograms_t* h = nullptr;
+    if (!h) {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.emplace_back(new thread_histograms_t);
+        h = registry.back().get();
+    }
+    return *h;
+}
+
+void enable_latency(bool on)
+{
+    g_latency_enabled.store(on, std::memory_order_relaxed);
+}
+
+void record_latency(latency_t id, uint64_t ns)
+{
+    this_thread_histograms().h[id].record(ns);
+}
+
+void merged_latency(latency_t id, LatencyHistogram& res)
+{
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (const auto& t : registry)
+        res.merge(t->h[id]);
+}
+
+void reset_latency()
+{
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (auto& t : registry)
+        for (auto& h : t->h)
+            h.reset();
+}
+
+void print_latency(std::ostream& os)
+{
+    std::ios_base::fmtflags flags = os.flags();
+    std::streamsize prec = os.precision();
+    os << std::fixed << std::setprecision(3);
+    for (size_t i = 0; i < n_latencies; ++i) {
+        LatencyHistogram h;
+        merged_latency(static_cast<latency_t>(i), h);
+        if (h.count() == 0)
+            continue;
+        os << latency_names[i] << separator << h.count()
+           << separator << h.percentile(0.5) * 1e-3
+           << separator << h.percentile(0.99) * 1e-3
+           << separator << h.percentile(0.999) * 1e-3
+           << separator << h.max() * 1e-3 << "\n";
+    }
+    os.flags(flags);
+    os.precision(prec);
+}
+
+void write_latency_json(std::ostream& os)
+{
+    std::ios_base::fmtflags flags = os.flags();
+    std::streamsize prec = os.precision();
+    os << std::fixed << std::setprecision(3);
+    os << "{";
+    bool first = true;
+    for (size_t i = 0; i < n_latencies; ++i) {
+        LatencyHistogram h;
+        merged_latency(static_cast<latency_t>(i), h);
+        if (h.count() == 0)
+            continue;
+        os << (first ? "\n" : ",\n")
+           << "    \"" << latency_names[i] << "\": { \"count\": " << h.count()
+           << ", \"p50_us\": " << h.percentile(0.5) * 1e-3
+           << ", \"p99_us\": " << h.percentile(0.99) * 1e-3
+           << ", \"p99.9_us\": " << h.percentile(0.999) * 1e-3
+           << ", \"max_us\": " << h.max() * 1e-3 << " }";
+        first = false;
+    }
+    os << (first ? "}" : "\n  }");
+    os.flags(flags);
+    os.precision(prec);
+}
+
+} // namespace perf
+} // namespace minirisk
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+#include "Global.h"
+
+namespace minirisk {
+
+namespace perf {
+
+// Histogram of latencies in nanoseconds with log-linear buckets (as in HdrHistogram):
+// each power of two is split in 2^sub_bits equal buckets, so that any recorded value is
+// known with a relative error below 2^-sub_bits, from 1ns up to the full 64 bit range.
+// A histogram has a single writer; it can be read (or merged into another one) while the
+// writer keeps recording.
+struct LatencyHistogram
+{
+    static const unsigned sub_bits = 5;
+    static const unsigned n_sub = 1u << sub_bits;
+    static const unsigned n_buckets = (64 - sub_bits + 1) * n_sub;
+
+    LatencyHistogram() { reset(); }
+
+    void record(uint64_t ns)
+    {
+        // single writer: plain load and store, no need for an atomic read-modify-write
+        auto& c = m_counts[bucket(ns)];
+        c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (ns > m_max.load(std::memory_order_relaxed))
+            m_max.store(ns, std::memory_order_relaxed);
+    }
+
+    // add the samples of another histogram (not thread safe with respect to this one)
+    void merge(const LatencyHistogram& h);
+
+    void reset();
+
+    uint64_t count() const;
+    uint64_t max() const { return m_max.load(std::memory_order_relaxed); }
+
+    // smallest latency (within the bucket resolution) not exceeded by a fraction p of the samples
+    uint64_t percentile(double p) const;
+
+    static unsigned bucket(uint64_t ns)
+    {
+        if (ns < n_sub)
+            return static_cast<unsigned>(ns);
+        unsigned group = 63 - static_cast<unsigned>(__builtin_clzll(ns)) - sub_bits + 1;
+        return group * n_sub + static_cast<unsigned>(ns >> (group - 1)) - n_sub;
+    }
+
+    // largest value falling in bucket i
+    static uint64_t bucket_upper(unsigned i)
+    {
+        unsigned group = i / n_sub;
+        if (group == 0)
+            return i;
+        uint64_t lower = static_cast<uint64_t>(i % n_sub + n_sub) << (group - 1);
+        return lower + ((uint64_t(1) << (group - 1)) - 1);
+    }
+
+private:
+    std::atomic<uint64_t> m_counts[n_buckets];
+    std::atomic<uint64_t> m_max;
+};
+
+// what is measured
+enum latency_t
+{
+    lat_pricer_payment,     // PricerPayment::price
+    lat_pricer_fx_forward,  // PricerFXForward::price
+    lat_compute_prices,     // one compute_prices call, i.e. one scenario
+    lat_curve_discount,     // CurveDiscount construction
+    lat_curve_fx_forward,   // CurveFXForward construction
+    n_latencies
+};
+
+extern std::atomic<bool> g_latency_enabled;
+
+inline bool latency_enabled()
+{
+    return g_latency_enabled.load(std::memory_order_relaxed);
+}
+
+// Turn latency recording on or off. Each thread records into its own histograms, so the
+// cost of a sample is two clock reads and a few uncontended memory accesses.
+void enable_latency(bool on = true);
+
+// record a sample in the histograms of the calling thread
+void record_latency(latency_t id, uint64_t ns);
+
+// merge into res the histograms of all threads
+void merged_latency(latency_t id, LatencyHistogram& res);
+
+// reset the histograms of all threads (not thread safe with respect to recording threads)
+void reset_latency();
+
+// one line per non empty histogram: name;count;p50;p99;p99.9;max (microseconds)
+void print_latency(std::ostream& os);
+
+// JSON object with an entry per non empty histogram
+void write_latency_json(std::ostream& os);
+
+// times the enclosing scope as one sample of the given latency histogram
+struct ScopedLatency
+{
+    explicit ScopedLatency(latency_t id)
+        : m_id(latency_enabled() ? static_cast<int>(id) : -1)
+    {
+        if (m_id >= 0)
+            m_start = std::chrono::steady_clock::now();
+    }
+
+    ~ScopedLatency()
+    {
+        if (m_id >= 0) {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+            record_latency(static_cast<latency_t>(m_id), static_cast<uint64_t>(ns));
+        }
+    }
+
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+    int m_id;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+} // namespace perf
+
+} // namespace minirisk
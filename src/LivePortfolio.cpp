@@ -0,0 +1,65 @@
+#include "LivePortfolio.h"
+#include "Macros.h"
+
+namespace minirisk {
+
+LivePortfolio::LivePortfolio(Market& mkt, const FixingDataServer* fds, const string& base_ccy)
+    : m_base_ccy(base_ccy)
+    , m_risk(std::vector<ppricer_t>(), mkt, fds)
+{
+    MYASSERT(!base_ccy.empty(), "Base currency cannot be empty");
+}
+
+size_t LivePortfolio::slot(const string& id) const
+{
+    auto it = m_slots.find(id);
+    MYASSERT(it != m_slots.end(), "Unknown trade id: " << id);
+    return it->second;
+}
+
+void LivePortfolio::insert(const string& id, const ptrade_t& trade)
+{
+    MYASSERT(!id.empty(), "Trade id cannot be empty");
+    MYASSERT(!contains(id), "Trade id already in use: " << id);
+    MYASSERT(trade.get() != nullptr, "Cannot insert a null trade");
+
+    ppricer_t pricer = trade->pricer(m_base_ccy);
+    size_t s = m_risk.add(pricer);
+    if (s >= m_trades.size()) {
+        m_trades.resize(s + 1);
+        m_pricers.resize(s + 1);
+    }
+    m_trades[s] = trade;
+    m_pricers[s] = pricer;
+    m_slots.emplace(id, s);
+}
+
+void LivePortfolio::amend(const string& id, const ptrade_t& trade)
+{
+    MYASSERT(trade.get() != nullptr, "Cannot amend with a null trade");
+    size_t s = slot(id);
+    ppricer_t pricer = trade->pricer(m_base_ccy);
+    m_risk.replace(s, pricer);
+    m_trades[s] = trade;
+    m_pricers[s] = pricer;
+}
+
+void LivePortfolio::cancel(const string& id)
+{
+    size_t s = slot(id);
+    m_risk.remove(s);
+    m_trades[s].reset();
+    m_pricers[s].reset();
+    m_slots.erase(id);
+}
+
+std::vector<string> LivePortfolio::ids() const
+{
+    std::vector<string> res;
+    res.reserve(m_slots.size());
+    for (const auto& s : m_slots)
+        res.push_back(s.first);
+    return res;
+}
+
+} // namespace minirisk
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <map>
+
+#include "IncrementalRisk.h"
+
+namespace minirisk {
+
+// A portfolio of trades identified by a booking id, which can be inserted, amended and
+// cancelled one at a time. Prices and sensitivities are cached per trade and the aggregates
+// are maintained incrementally, so a trade change only prices the trade concerned.
+struct LivePortfolio
+{
+    typedef IncrementalRisk::total_t total_t;
+
+    // all risk factors that may be updated must be cached in mkt
+    LivePortfolio(Market& mkt, const FixingDataServer* fds, const string& base_ccy);
+
+    // book a new trade; the id must not be in use
+    void insert(const string& id, const ptrade_t& trade);
+
+    // replace an existing trade
+    void amend(const string& id, const ptrade_t& trade);
+
+    // remove an existing trade
+    void cancel(const string& id);
+
+    // update risk factors, repricing the dependent trades. Returns the number of trades repriced.
+    size_t update(const Market::vec_risk_factor_t& risk_factors) { return m_risk.update(risk_factors); }
+
+    bool contains(const string& id) const { return m_slots.count(id) > 0; }
+    size_t size() const { return m_slots.size(); }
+
+    // ids of the trades in the portfolio, in lexicographic order
+    std::vector<string> ids() const;
+
+    const ptrade_t& trade(const string& id) const { return m_trades[slot(id)]; }
+    const ppricer_t& pricer(const string& id) const { return m_pricers[slot(id)]; }
+
+    // cached price of a trade (NaN and error message if it could not be priced)
+    const std::pair<double, string>& price(const string& id) const { return m_risk.prices()[slot(id)]; }
+
+    // cached per risk factor sensitivities of a trade
+    const std::map<string, std::pair<double, string>>& sensitivities(const string& id) const { return m_risk.sensitivities(slot(id)); }
+
+    // portfolio PV
+    total_t total() const { return m_risk.total(); }
+
+    // sensitivity totals per risk factor (PV01 for IR rates, delta for FX spots)
+    const std::map<string, total_t>& sensitivities() const { return m_risk.sensitivities(); }
+
+private:
+    size_t slot(const string& id) const;
+
+    string m_base_ccy;
+    IncrementalRisk m_risk;
+    std::map<string, size_t> m_slots;
+
+    // trades and pricers by slot
+    portfolio_t m_trades;
+    std::vector<ppricer_t> m_pricers;
+};
+
+} // namespace minirisk
@@ -0,0 +1,109 @@
+#include "LocalSocket.h"
+#include "Macros.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace minirisk {
+
+static sockaddr_un make_address(const string& path)
+{
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    MYASSERT(path.size() < sizeof(addr.sun_path), "Socket path too long: " << path);
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    return addr;
+}
+
+LocalSocket LocalSocket::connect(const string& path)
+{
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    MYASSERT(fd >= 0, "Cannot create socket: " << std::strerror(errno));
+    LocalSocket s(fd);
+    sockaddr_un addr = make_address(path);
+    MYASSERT(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0,
+        "Cannot connect to " << path << ": " << std::strerror(errno));
+    return LocalSocket(s.release());
+}
+
+LocalSocket LocalSocket::listen(const string& path)
+{
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    MYASSERT(fd >= 0, "Cannot create socket: " << std::strerror(errno));
+    LocalSocket s(fd);
+    sockaddr_un addr = make_address(path);
+    ::unlink(path.c_str());
+    MYASSERT(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0,
+        "Cannot bind to " << path << ": " << std::strerror(errno));
+    MYASSERT(::listen(fd, 16) == 0, "Cannot listen on " << path << ": " << std::strerror(errno));
+    return LocalSocket(s.release());
+}
+
+int LocalSocket::accept() const
+{
+    int fd;
+    do {
+        fd = ::accept(m_fd, nullptr, nullptr);
+    } while (fd < 0 && errno == EINTR);
+    MYASSERT(fd >= 0, "Cannot accept connection: " << std::strerror(errno));
+    return fd;
+}
+
+bool LocalSocket::read_line(string& line)
+{
+    size_t pos;
+    while ((pos = m_buf.find('\n')) == string::npos) {
+        char tmp[4096];
+        ssize_t n = ::read(m_fd, tmp, sizeof(tmp));
+        if (n < 0 && errno == EINTR)
+            continue;
+        MYASSERT(n >= 0, "Socket read failed: " << std::strerror(errno));
+        if (n == 0) {
+            // end of stream: return a last unterminated line, if any
+            if (m_buf.empty())
+                return false;
+            line.swap(m_buf);
+            m_buf.clear();
+            return true;
+        }
+        m_buf.append(tmp, static_cast<size_t>(n));
+    }
+    line.assign(m_buf, 0, pos);
+    m_buf.erase(0, pos + 1);
+    return true;
+}
+
+void LocalSocket::write(const string& s) const
+{
+    const char *p = s.data();
+    size_t left = s.size();
+    while (left > 0) {
+        ssize_t n = ::send(m_fd, p, left, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        MYASSERT(n > 0, "Socket write failed: " << std::strerror(errno));
+        p += n;
+        left -= static_cast<size_t>(n);
+    }
+}
+
+int LocalSocket::release()
+{
+    int fd = m_fd;
+    m_fd = -1;
+    return fd;
+}
+
+void LocalSocket::close()
+{
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+} // namespace minirisk
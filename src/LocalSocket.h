@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Global.h"
+
+namespace minirisk {
+
+// Minimal line oriented client/server transport over Unix domain sockets (POSIX only).
+// Errors are reported by throwing, as everywhere else.
+struct LocalSocket
+{
+    // take ownership of an already connected file descriptor
+    explicit LocalSocket(int fd = -1) : m_fd(fd) {}
+    ~LocalSocket() { close(); }
+
+    LocalSocket(const LocalSocket&) = delete;
+    LocalSocket& operator=(const LocalSocket&) = delete;
+
+    // connect to a server listening on path
+    static LocalSocket connect(const string& path);
+
+    // bind and listen on path, removing any stale socket file first
+    static LocalSocket listen(const string& path);
+
+    // wait for the next client connection (listening sockets only)
+    int accept() const;
+
+    // read a line, without the trailing newline. Returns false on end of stream.
+    bool read_line(string& line);
+
+    // write the whole buffer
+    void write(const string& s) const;
+
+    bool valid() const { return m_fd >= 0; }
+    void close();
+
+    // give up ownership of the file descriptor
+    int release();
+
+private:
+    int    m_fd;
+    string m_buf;  // bytes received but not yet returned by read_line
+};
+
+} // namespace minirisk
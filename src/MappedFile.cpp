@@ -0,0 +1,46 @@
+#include "MappedFile.h"
+#include "Macros.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace minirisk {
+
+MappedFile::MappedFile(const string& filename)
+    : m_data(nullptr)
+    , m_size(0)
+{
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    MYASSERT(fd >= 0, "Could not open file " << filename);
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        int err = errno;
+        ::close(fd);
+        THROW("Could not stat file " << filename << ": " << std::strerror(err));
+    }
+    m_size = static_cast<size_t>(st.st_size);
+
+    if (m_size > 0) {
+        void* p = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        int err = errno;
+        ::close(fd);
+        MYASSERT(p != MAP_FAILED, "Could not map file " << filename << ": " << std::strerror(err));
+        ::madvise(p, m_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const char*>(p);
+    } else {
+        ::close(fd);
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data)
+        ::munmap(const_cast<char*>(m_data), m_size);
+}
+
+} // namespace minirisk
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+
+#include "Global.h"
+
+namespace minirisk {
+
+// Read only memory map of a whole file (POSIX only). An empty file maps to no data.
+struct MappedFile
+{
+    explicit MappedFile(const string& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    const char* m_data;
+    size_t      m_size;
+};
+
+} // namespace minirisk
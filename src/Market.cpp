@@ -2,18 +2,46 @@
 #include "CurveDiscount.h"
 #include "CurveFXSpot.h"
 #include "CurveFXForward.h"
+#include "PerfCounters.h"
 
 #include <vector>
 #include <limits>
+#include <atomic>
 
 namespace minirisk {
 
+// instrumentation counter of the constructions of each curve type
+template <typename T> struct curve_counter;
+template <> struct curve_counter<CurveDiscount> { static const perf::counter_t id = perf::curves_discount; };
+template <> struct curve_counter<CurveFXSpot> { static const perf::counter_t id = perf::curves_fx_spot; };
+template <> struct curve_counter<CurveFXForward> { static const perf::counter_t id = perf::curves_fx_forward; };
+
 template <typename I, typename T>
 std::shared_ptr<const I> Market::get_curve(const string& name) const
 {
     ptr_curve_t& curve_ptr = m_curves[name];
-    if (!curve_ptr.get())
-        curve_ptr.reset(new T(this, m_today, name));
+    if (!curve_ptr.get()) {
+        // record the risk factors used to build the curve
+        std::set<string> deps;
+        std::set<string>* outer = m_recorder;
+        m_recorder = &deps;
+        try {
+            if (m_arena)
+                curve_ptr = make_shared_in_arena<T>(m_arena, this, m_today, name);
+            else
+                curve_ptr.reset(new T(this, m_today, name));
+        } catch (...) {
+            m_recorder = outer;
+            throw;
+        }
+        m_recorder = outer;
+        m_curve_deps[name].swap(deps);
+        perf::count(curve_counter<T>::id);
+    }
+    if (m_recorder) {
+        const auto& deps = m_curve_deps[name];
+        m_recorder->insert(deps.begin(), deps.end());
+    }
     std::shared_ptr<const I> res = std::dynamic_pointer_cast<const I>(curve_ptr);
     MYASSERT(res, "Cannot cast object with name " << name << " to type " << typeid(I).name());
     return res;
@@ -36,10 +64,21 @@ const ptr_fx_fwd_curve_t Market::get_fx_fwd_curve(const string& name) const
 
 double Market::from_mds(const string& objtype, const string& name) const
 {
+    if (m_recorder)
+        m_recorder->insert(name);
+    perf::count(perf::risk_factor_lookups);
     auto ins = m_risk_factors.emplace(name, std::numeric_limits<double>::quiet_NaN());
     if (ins.second) { // just inserted, need to be populated
-        MYASSERT(m_mds, "Cannot fetch " << objtype << " " << name << " because the market data server has been disconnnected");
-        ins.first->second = m_mds->get(name);
+        perf::count(perf::mds_fetches);
+        // a failed fetch is not cached, so that each lookup of a missing risk factor fails in
+        // the same way, whichever trade is priced first
+        try {
+            MYASSERT(m_mds, "Cannot fetch " << objtype << " " << name << " because the market data server has been disconnnected");
+            ins.first->second = m_mds->get(name);
+        } catch (...) {
+            m_risk_factors.erase(ins.first);
+            throw;
+        }
     }
     return ins.first->second;
 }
@@ -55,9 +94,24 @@ const double Market::get_fx_spot(const string& name) const
     return from_mds("fx spot", mds_spot_name(name));
 }
 
+static std::atomic<bool> arenas_enabled(true);
+
+void Market::enable_arenas(bool on)
+{
+    arenas_enabled.store(on, std::memory_order_relaxed);
+}
+
+void Market::use_arena()
+{
+    if (!m_arena && arenas_enabled.load(std::memory_order_relaxed))
+        m_arena.reset(new ScenarioArena);
+}
+
 void Market::set_risk_factors(const vec_risk_factor_t& risk_factors)
 {
     clear();
+    if (m_arena)
+        m_arena->reset();
     for (const auto& d : risk_factors) {
         auto i = m_risk_factors.find(d.first);
         MYASSERT((i != m_risk_factors.end()), "Risk factor not found " << d.first);
@@ -65,10 +119,31 @@ void Market::set_risk_factors(const vec_risk_factor_t& risk_factors)
     }
 }
 
+void Market::update_risk_factors(const vec_risk_factor_t& risk_factors)
+{
+    for (const auto& d : risk_factors) {
+        auto i = m_risk_factors.find(d.first);
+        MYASSERT((i != m_risk_factors.end()), "Risk factor not found " << d.first);
+        i->second = d.second;
+    }
+    for (auto& c : m_curves) {
+        if (!c.second)
+            continue;
+        const auto& deps = m_curve_deps[c.first];
+        for (const auto& d : risk_factors) {
+            if (deps.count(d.first)) {
+                c.second.reset();
+                break;
+            }
+        }
+    }
+}
+
 Market::vec_risk_factor_t Market::get_risk_factors(const std::string& expr) const
 {
     vec_risk_factor_t result;
     std::regex r(expr);
+    perf::count(perf::regex_evaluations, m_risk_factors.size());
     for (const auto& d : m_risk_factors)
         if (std::regex_match(d.first, r))
             result.push_back(d);
@@ -4,7 +4,9 @@
 #include "IObject.h"
 #include "ICurve.h"
 #include "MarketDataServer.h"
+#include "ScenarioArena.h"
 #include <vector>
+#include <set>
 #include <regex>
 
 namespace minirisk {
@@ -26,9 +28,24 @@ public:
     Market(const std::shared_ptr<const MarketDataServer>& mds, const Date& today)
         : m_today(today)
         , m_mds(mds)
+        , m_recorder(nullptr)
     {
     }
 
+    // copies share the market objects, but not the arena: a copy allocates new objects on the heap
+    // until it gets its own arena
+    Market(const Market& m)
+        : m_today(m.m_today)
+        , m_mds(m.m_mds)
+        , m_curves(m.m_curves)
+        , m_curve_deps(m.m_curve_deps)
+        , m_recorder(m.m_recorder)
+        , m_risk_factors(m.m_risk_factors)
+    {
+    }
+
+    Market& operator=(const Market&) = delete;
+
     virtual Date today() const { return m_today; }
 
     // get an object of type ICurveDisocunt
@@ -63,6 +80,13 @@ public:
         return m_mds->match(expr);
     }
 
+    // names of the IR tenor points of a currency
+    const std::vector<std::string>& ir_tenor_keys(const std::string& ccy) const
+    {
+        MYASSERT(m_mds, "Cannot list the tenors of " << ccy << " because the market data server has been disconnnected");
+        return m_mds->ir_tenors(ccy);
+    }
+
     // fetch a single risk factor value by exact name (with caching)
     double get_value(const string& name, const string& objtype) const
     {
@@ -75,9 +99,52 @@ public:
         std::for_each(m_curves.begin(), m_curves.end(), [](auto& p) { p.second.reset(); });
     }
 
-    // destroy all existing objects and modify a selected number of data points
+    // destroy all existing objects and modify a selected number of data points.
+    // With an arena, its memory is recycled once the objects destroyed were its last users.
     void set_risk_factors(const vec_risk_factor_t& risk_factors);
 
+    // Build the market objects (and their data) in an arena owned by this market instead of
+    // on the heap. Meant for the temporary markets used to apply bumps, whose objects are all
+    // rebuilt for each scenario. Does nothing if arenas are disabled.
+    void use_arena();
+
+    // memory resource for the data of market objects: the arena if any, or the heap
+    std::pmr::memory_resource* memory_resource() const
+    {
+        return m_arena ? static_cast<std::pmr::memory_resource*>(m_arena.get()) : std::pmr::get_default_resource();
+    }
+
+    const ScenarioArena* arena() const { return m_arena.get(); }
+
+    // enable or disable use_arena globally (enabled by default), e.g. to compare allocations
+    static void enable_arenas(bool on);
+
+    // modify a selected number of data points, destroying only the objects built from them
+    void update_risk_factors(const vec_risk_factor_t& risk_factors);
+
+    // while deps is not null, collect in it the names of all risk factors accessed, including
+    // those used to build the curves accessed
+    void record_dependencies(std::set<string>* deps) { m_recorder = deps; }
+
+    // a dependency recorder is active
+    bool recording() const { return m_recorder != nullptr; }
+
+    // add names to the active dependency recorder, if any (e.g. those recorded by a copy of
+    // this market used on another thread)
+    void add_dependencies(const std::set<string>& names) const
+    {
+        if (m_recorder)
+            m_recorder->insert(names.begin(), names.end());
+    }
+
+    // Add the risk factors fetched by other, a copy of this market used on another thread,
+    // which this market has not fetched yet. Curves are not shared back, as some of them
+    // refer to the market which built them.
+    void merge_risk_factors(const Market& other)
+    {
+        m_risk_factors.insert(other.m_risk_factors.begin(), other.m_risk_factors.end());
+    }
+
 private:
     Date m_today;
     std::shared_ptr<const MarketDataServer> m_mds;
@@ -85,8 +152,17 @@ private:
     // market curves
     mutable std::map<string, ptr_curve_t> m_curves;
 
+    // risk factors read to build each curve
+    mutable std::map<string, std::set<string>> m_curve_deps;
+
+    // active dependency recorder, if any
+    mutable std::set<string>* m_recorder;
+
     // raw risk factors (mutable to allow caching in const getters)
     mutable std::map<string, double> m_risk_factors;
+
+    // memory for the market objects, if any (also owned by the objects allocated in it)
+    parena_t m_arena;
 };
 
 } // namespace minirisk
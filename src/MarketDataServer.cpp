@@ -1,6 +1,8 @@
 #include "MarketDataServer.h"
 #include "Macros.h"
 #include "Streamer.h"
+#include "PerfCounters.h"
+#include "MarketSnapshot.h"
 
 #include <limits>
 
@@ -27,10 +29,54 @@ MarketDataServer::MarketDataServer(const string& filename)
         auto ins = m_data.emplace(name, value);
         MYASSERT(ins.second, "Duplicated risk factor: " << name);
     } while (is);
+
+    for (const auto& kv : m_data)
+        index_ir_tenor(kv.first);
+}
+
+MarketDataServer::MarketDataServer(const std::shared_ptr<const MarketSnapshot>& snapshot)
+    : m_snapshot(snapshot)
+{
+    MYASSERT(m_snapshot, "Market snapshot cannot be null");
+    for (size_t i = 0; i < m_snapshot->size(); ++i)
+        index_ir_tenor(string(m_snapshot->key(i)));
+}
+
+// add name to the IR tenor points of its currency if it is one (names come in sorted order)
+void MarketDataServer::index_ir_tenor(const string& name)
+{
+    static const std::regex tenor("^IR\\.[0-9]+[DWMY]\\.(.+)$");
+    std::smatch m;
+    if (std::regex_match(name, m, tenor))
+        m_ir_tenors[m[1].str()].push_back(name);
+}
+
+std::vector<std::pair<string, double>> MarketDataServer::entries() const
+{
+    if (m_snapshot) {
+        std::vector<std::pair<string, double>> res;
+        res.reserve(m_snapshot->size());
+        for (size_t i = 0; i < m_snapshot->size(); ++i)
+            res.emplace_back(string(m_snapshot->key(i)), m_snapshot->value(i));
+        return res;
+    }
+    return std::vector<std::pair<string, double>>(m_data.begin(), m_data.end());
+}
+
+const std::vector<string>& MarketDataServer::ir_tenors(const string& ccy) const
+{
+    static const std::vector<string> none;
+    auto iter = m_ir_tenors.find(ccy);
+    return iter == m_ir_tenors.end() ? none : iter->second;
 }
 
 double MarketDataServer::get(const string& name) const
 {
+    if (m_snapshot) {
+        size_t i = m_snapshot->find(name);
+        MYASSERT(i < m_snapshot->size(), "Market data not found: " << name);
+        return m_snapshot->value(i);
+    }
     auto iter = m_data.find(name);
     MYASSERT(iter != m_data.end(), "Market data not found: " << name);
     return iter->second;
@@ -38,6 +84,12 @@ double MarketDataServer::get(const string& name) const
 
 std::pair<double, bool> MarketDataServer::lookup(const string& name) const
 {
+    if (m_snapshot) {
+        size_t i = m_snapshot->find(name);
+        return (i < m_snapshot->size())
+                ? std::make_pair(m_snapshot->value(i), true)
+                : std::make_pair(std::numeric_limits<double>::quiet_NaN(), false);
+    }
     auto iter = m_data.find(name);
     return (iter != m_data.end())  // found?
             ? std::make_pair(iter->second, true)
@@ -48,6 +100,16 @@ std::vector<std::string> MarketDataServer::match(const std::string& expr) const
 {
     std::regex r(expr);
     std::vector<std::string> out;
+    if (m_snapshot) {
+        perf::count(perf::regex_evaluations, m_snapshot->size());
+        for (size_t i = 0; i < m_snapshot->size(); ++i) {
+            string name(m_snapshot->key(i));
+            if (std::regex_match(name, r))
+                out.push_back(std::move(name));
+        }
+        return out;
+    }
+    perf::count(perf::regex_evaluations, m_data.size());
     for (const auto& kv : m_data) {
         if (std::regex_match(kv.first, r))
             out.push_back(kv.first);
@@ -2,10 +2,13 @@
 
 #include <map>
 #include <regex>
+#include <memory>
 #include "Global.h"
 
 namespace minirisk {
 
+struct MarketSnapshot;
+
 // This is a dummy object that in a real system should be replaced by a server providing
 // with real time (or historical) market data on demand and capable to produce snapshots of data.
 // For the purpose of this example this simply serves to clients some stale pre-loaded market info.
@@ -14,14 +17,32 @@ struct MarketDataServer
 public:
     MarketDataServer(const string& filename);
 
+    // serves the risk factors of a snapshot in shared memory, without copying them
+    explicit MarketDataServer(const std::shared_ptr<const MarketSnapshot>& snapshot);
+
     // queries
     double get(const string& name) const;
     std::pair<double, bool> lookup(const string& name) const;
     std::vector<std::string> match(const std::string& expr) const;
 
+    // names of the IR tenor points (IR.<n><unit>.<ccy>) of a currency, indexed at load time
+    // so that building a curve needs neither a regular expression nor a new vector
+    const std::vector<string>& ir_tenors(const string& ccy) const;
+
+    // all risk factors, sorted by name
+    std::vector<std::pair<string, double>> entries() const;
+
 private:
+    void index_ir_tenor(const string& name);
+
     // for simplicity, assumes market data can only have type double
     std::map<string, double> m_data;
+
+    // snapshot serving the data instead of m_data, if any
+    std::shared_ptr<const MarketSnapshot> m_snapshot;
+
+    // IR tenor point names by currency
+    std::map<string, std::vector<string>> m_ir_tenors;
 };
 
 string mds_spot_name(const string& name);
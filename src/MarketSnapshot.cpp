@@ -0,0 +1,138 @@
+#include "MarketSnapshot.h"
+#include "MarketDataServer.h"
+#include "Macros.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace minirisk {
+
+static const char snapshot_magic[8] = { 'M', 'R', 'S', 'N', 'A', 'P', '0', '1' };
+
+MarketSnapshot::MarketSnapshot(const string& name, const MarketDataServer& mds)
+    : m_name(name)
+    , m_owner(true)
+    , m_data(nullptr)
+    , m_size(0)
+    , m_n(0)
+    , m_entries(nullptr)
+    , m_names(nullptr)
+{
+    // entries() is sorted by name
+    const auto entries = mds.entries();
+    size_t names_size = 0;
+    for (const auto& e : entries)
+        names_size += e.first.size();
+    const size_t size = sizeof(header_t) + entries.size() * sizeof(entry_t) + names_size;
+
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    MYASSERT(fd >= 0, "Could not create shared memory " << name << ": " << std::strerror(errno));
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        int err = errno;
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        THROW("Could not size shared memory " << name << ": " << std::strerror(err));
+    }
+    void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int err = errno;
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        ::shm_unlink(name.c_str());
+        THROW("Could not map shared memory " << name << ": " << std::strerror(err));
+    }
+
+    char* base = static_cast<char*>(p);
+    header_t* header = reinterpret_cast<header_t*>(base);
+    entry_t* out = reinterpret_cast<entry_t*>(base + sizeof(header_t));
+    char* names = base + sizeof(header_t) + entries.size() * sizeof(entry_t);
+    uint64_t offset = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        out[i].value = entries[i].second;
+        out[i].name_offset = offset;
+        out[i].name_length = entries[i].first.size();
+        std::memcpy(names + offset, entries[i].first.data(), entries[i].first.size());
+        offset += entries[i].first.size();
+    }
+    std::memcpy(header->magic, snapshot_magic, sizeof(snapshot_magic));
+    header->n_entries = entries.size();
+    header->size = size;
+
+    // the creator only reads from now on
+    ::mprotect(p, size, PROT_READ);
+    m_data = p;
+    m_size = size;
+    m_n = entries.size();
+    m_entries = out;
+    m_names = names;
+}
+
+MarketSnapshot::MarketSnapshot(const string& name)
+    : m_name(name)
+    , m_owner(false)
+    , m_data(nullptr)
+    , m_size(0)
+    , m_n(0)
+    , m_entries(nullptr)
+    , m_names(nullptr)
+{
+    int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    MYASSERT(fd >= 0, "Could not open shared memory " << name << ": " << std::strerror(errno));
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        int err = errno;
+        ::close(fd);
+        THROW("Could not stat shared memory " << name << ": " << std::strerror(err));
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    if (size < sizeof(header_t)) {
+        ::close(fd);
+        THROW("Invalid market snapshot " << name << ": too small");
+    }
+    void* p = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    int err = errno;
+    ::close(fd);
+    MYASSERT(p != MAP_FAILED, "Could not map shared memory " << name << ": " << std::strerror(err));
+    m_data = p;
+    m_size = size;
+
+    const char* base = static_cast<const char*>(p);
+    const header_t* header = reinterpret_cast<const header_t*>(base);
+    MYASSERT(std::memcmp(header->magic, snapshot_magic, sizeof(snapshot_magic)) == 0, "Invalid market snapshot " << name << ": bad magic");
+    MYASSERT(header->size == size && header->n_entries <= (size - sizeof(header_t)) / sizeof(entry_t),
+        "Invalid market snapshot " << name << ": inconsistent size");
+    m_n = header->n_entries;
+    m_entries = reinterpret_cast<const entry_t*>(base + sizeof(header_t));
+    m_names = base + sizeof(header_t) + m_n * sizeof(entry_t);
+    const size_t names_size = size - sizeof(header_t) - m_n * sizeof(entry_t);
+    for (size_t i = 0; i < m_n; ++i)
+        MYASSERT(m_entries[i].name_offset <= names_size && m_entries[i].name_length <= names_size - m_entries[i].name_offset,
+            "Invalid market snapshot " << name << ": name " << i << " out of bounds");
+}
+
+MarketSnapshot::~MarketSnapshot()
+{
+    if (m_data)
+        ::munmap(m_data, m_size);
+    if (m_owner)
+        ::shm_unlink(m_name.c_str());
+}
+
+size_t MarketSnapshot::find(std::string_view name) const
+{
+    size_t lo = 0, hi = m_n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (key(mid) < name)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return (lo < m_n && key(lo) == name) ? lo : m_n;
+}
+
+} // namespace minirisk
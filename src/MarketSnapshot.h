@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+#include "Global.h"
+
+namespace minirisk {
+
+struct MarketDataServer;
+
+// Read only copy of the risk factors of a MarketDataServer in POSIX shared memory, so that the
+// processes of a run on the same machine attach to one market instead of each loading the
+// risk factors file.
+//
+// Layout of the shared memory object (native byte order):
+//   header    magic "MRSNAP01", number of risk factors, size of the object
+//   entries   per risk factor, sorted by name: value, offset and length of the name
+//   names     characters of the names
+struct MarketSnapshot
+{
+    // Create the shared memory object name (e.g. "/minirisk.1234") with the risk factors of
+    // mds. The object is removed when this snapshot is destroyed: the processes attached to
+    // it keep their mapping.
+    MarketSnapshot(const string& name, const MarketDataServer& mds);
+
+    // attach read only to the shared memory object name, created by another process
+    explicit MarketSnapshot(const string& name);
+
+    ~MarketSnapshot();
+
+    MarketSnapshot(const MarketSnapshot&) = delete;
+    MarketSnapshot& operator=(const MarketSnapshot&) = delete;
+
+    const string& name() const { return m_name; }
+
+    // number of risk factors
+    size_t size() const { return m_n; }
+
+    // name and value of the i-th risk factor, in order of name
+    std::string_view key(size_t i) const { return std::string_view(m_names + m_entries[i].name_offset, m_entries[i].name_length); }
+    double value(size_t i) const { return m_entries[i].value; }
+
+    // index of a risk factor, or size() if there is none with this name
+    size_t find(std::string_view name) const;
+
+private:
+    struct entry_t
+    {
+        double value;
+        uint64_t name_offset;
+        uint64_t name_length;
+    };
+
+    struct header_t
+    {
+        char magic[8];
+        uint64_t n_entries;
+        uint64_t size;
+    };
+
+    string m_name;
+    bool m_owner;
+    void* m_data;
+    size_t m_size;
+    size_t m_n;
+    const entry_t* m_entries;
+    const char* m_names;
+};
+
+} // namespace minirisk
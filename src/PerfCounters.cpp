@@ -0,0 +1,133 @@
+#include "PerfCounters.h"
+
+#include <mutex>
+#include <vector>
+#include <iomanip>
+#include <algorithm>
+
+namespace minirisk {
+namespace perf {
+
+std::atomic<bool> g_enabled(false);
+std::atomic<bool> g_hw_enabled(false);
+std::atomic<size_t> g_counters[n_counters];
+
+static const char* const counter_names[n_counters] = {
+    "curves_constructed.discount",
+    "curves_constructed.fx_spot",
+    "curves_constructed.fx_forward",
+    "risk_factor_lookups",
+    "mds_fetches",
+    "pricing_calls",
+    "pricing_errors",
+    "regex_evaluations",
+    "heap_allocations",
+    "tasks_run",
+    "tasks_stolen"
+};
+
+// phases are few and recorded once per occurrence, so a lock is cheap enough
+static std::mutex phases_mutex;
+static std::vector<phase_t> recorded_phases;
+
+void enable(bool on)
+{
+    g_enabled.store(on, std::memory_order_relaxed);
+}
+
+void enable_hw(bool on)
+{
+    g_hw_enabled.store(on, std::memory_order_relaxed);
+}
+
+void reset()
+{
+    for (auto& c : g_counters)
+        c.store(0, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(phases_mutex);
+    recorded_phases.clear();
+}
+
+void add_phase(const char* name, double wall, double cpu, size_t trades, size_t allocations, const HwCounters::sample_t* hw)
+{
+    std::lock_guard<std::mutex> lock(phases_mutex);
+    auto p = std::find_if(recorded_phases.begin(), recorded_phases.end(), [name](const phase_t& p) { return p.name == name; });
+    if (p == recorded_phases.end()) {
+        recorded_phases.push_back(phase_t{ name, 0, 0.0, 0.0, 0, 0, false, {} });
+        p = recorded_phases.end() - 1;
+    }
+    ++p->calls;
+    p->wall += wall;
+    p->cpu += cpu;
+    p->trades += trades;
+    p->allocations += allocations;
+    if (hw) {
+        for (size_t i = 0; i < n_hw_counters; ++i)
+            p->hw_counts[i] = (hw->values[i] < 0 || (p->hw && p->hw_counts[i] < 0)) ? -1 : p->hw_counts[i] + hw->values[i];
+        p->hw = true;
+    }
+}
+
+std::vector<phase_t> phases()
+{
+    std::lock_guard<std::mutex> lock(phases_mutex);
+    return recorded_phases;
+}
+
+static void write_hw_json(std::ostream& os, const phase_t& p)
+{
+    const int64_t* c = p.hw_counts;
+    os << ", \"hw\": {";
+    for (size_t i = 0; i < n_hw_counters; ++i)
+        os << (i ? ", " : " ") << "\"" << hw_counter_names[i] << "\": " << c[i];
+    if (c[hw_cycles] > 0 && c[hw_instructions] >= 0)
+        os << ", \"ipc\": " << static_cast<double>(c[hw_instructions]) / static_cast<double>(c[hw_cycles]);
+    if (p.trades > 0) {
+        if (c[hw_llc_misses] >= 0)
+            os << ", \"llc_misses_per_trade\": " << static_cast<double>(c[hw_llc_misses]) / static_cast<double>(p.trades);
+        if (c[hw_branch_misses] >= 0)
+            os << ", \"branch_misses_per_trade\": " << static_cast<double>(c[hw_branch_misses]) / static_cast<double>(p.trades);
+    }
+    os << " }";
+}
+
+void write_json(std::ostream& os)
+{
+    std::lock_guard<std::mutex> lock(phases_mutex);
+    std::ios_base::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(3);
+
+    os << "{\n  \"phases\": {";
+    for (size_t i = 0; i < recorded_phases.size(); ++i) {
+        const auto& p = recorded_phases[i];
+        os << (i ? ",\n" : "\n")
+           << "    \"" << p.name << "\": { \"calls\": " << p.calls
+           << ", \"wall_ms\": " << p.wall * 1e3
+           << ", \"cpu_ms\": " << p.cpu * 1e3
+           << ", \"trades\": " << p.trades
+           << ", \"allocations\": " << p.allocations;
+        if (p.hw)
+            write_hw_json(os, p);
+        os << " }";
+    }
+    os << "\n  },\n  \"counters\": {";
+    for (size_t i = 0; i < n_counters; ++i)
+        os << (i ? ",\n" : "\n")
+           << "    \"" << counter_names[i] << "\": " << g_counters[i].load(std::memory_order_relaxed);
+    os << "\n  }";
+    if (latency_enabled()) {
+        os << ",\n  \"latencies\": ";
+        write_latency_json(os);
+    }
+    if (hw_enabled()) {
+        const HwCounters& hw = this_thread_hw_counters();
+        os << ",\n  \"hardware_counters\": { \"available\": " << (hw.available() ? "true" : "false")
+           << ", \"status\": \"" << hw.status() << "\" }";
+    }
+    os << "\n}\n";
+
+    os.flags(flags);
+}
+
+} // namespace perf
+} // namespace minirisk
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <vector>
+
+#include "Global.h"
+#include "HwCounters.h"
+#include "LatencyHistogram.h"
+
+namespace minirisk {
+
+// Lightweight instrumentation: event counters and phase timers, reported as JSON.
+// Everything is disabled by default, in which case each probe costs one relaxed atomic load
+// and a branch. Counters can be incremented from any thread.
+namespace perf {
+
+enum counter_t
+{
+    curves_discount,        // CurveDiscount objects constructed by Market
+    curves_fx_spot,         // CurveFXSpot objects constructed by Market
+    curves_fx_forward,      // CurveFXForward objects constructed by Market
+    risk_factor_lookups,    // risk factor requests served by Market
+    mds_fetches,            // of which fetched from the market data server
+    pricing_calls,          // calls to IPricer::price
+    pricing_errors,         // of which failed with an exception
+    regex_evaluations,      // std::regex_match calls
+    heap_allocations,       // operator new calls, in programs installing a counting hook
+    tasks_run,              // ranges run by TaskScheduler
+    tasks_stolen,           // of which stolen from the deque of another thread
+    n_counters
+};
+
+extern std::atomic<bool> g_enabled;
+extern std::atomic<bool> g_hw_enabled;
+extern std::atomic<size_t> g_counters[n_counters];
+
+inline bool enabled()
+{
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+inline bool hw_enabled()
+{
+    return g_hw_enabled.load(std::memory_order_relaxed);
+}
+
+// turn instrumentation on or off (counters and timers are not reset)
+void enable(bool on = true);
+
+// also sample the hardware counters of the threads running each phase
+void enable_hw(bool on = true);
+
+// reset all counters and timers
+void reset();
+
+inline void count(counter_t c, size_t n = 1)
+{
+    if (enabled())
+        g_counters[c].fetch_add(n, std::memory_order_relaxed);
+}
+
+// accumulated measurements of all occurrences of a phase
+struct phase_t
+{
+    string name;
+    size_t calls;
+    double wall;                    // seconds
+    double cpu;                     // seconds
+    size_t trades;                  // pricing calls
+    size_t allocations;             // heap allocations (if counted)
+    bool hw;                        // hardware counters were sampled
+    int64_t hw_counts[n_hw_counters];  // -1 if not supported
+};
+
+// add one occurrence of a phase, with its elapsed wall and CPU time in seconds, the number
+// of pricing calls and heap allocations, and optionally the hardware counter deltas
+void add_phase(const char* name, double wall, double cpu, size_t trades, size_t allocations, const HwCounters::sample_t* hw);
+
+// phases recorded so far, in order of first occurrence
+std::vector<phase_t> phases();
+
+// times the enclosing scope as one occurrence of the named phase.
+// CPU time is process wide, so it includes all threads working during the phase, and so do
+// the hardware counters: those of the thread which created the ScopedPhase, and those of the
+// TaskScheduler threads (see all_threads_hw_counters).
+struct ScopedPhase
+{
+    explicit ScopedPhase(const char* name)
+        : m_name(enabled() ? name : nullptr)
+        , m_hw(nullptr)
+    {
+        if (m_name) {
+            if (hw_enabled() && this_thread_hw_counters().available()) {
+                m_hw = &this_thread_hw_counters();
+                m_hw_start = all_threads_hw_counters();
+            }
+            m_trades = g_counters[pricing_calls].load(std::memory_order_relaxed);
+            m_allocations = g_counters[heap_allocations].load(std::memory_order_relaxed);
+            m_wall = std::chrono::steady_clock::now();
+            m_cpu = std::clock();
+        }
+    }
+
+    ~ScopedPhase()
+    {
+        if (m_name) {
+            double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_wall).count();
+            double cpu = static_cast<double>(std::clock() - m_cpu) / CLOCKS_PER_SEC;
+            size_t trades = g_counters[pricing_calls].load(std::memory_order_relaxed) - m_trades;
+            size_t allocations = g_counters[heap_allocations].load(std::memory_order_relaxed) - m_allocations;
+            if (m_hw) {
+                HwCounters::sample_t hw = all_threads_hw_counters();
+                for (size_t i = 0; i < n_hw_counters; ++i)
+                    hw.values[i] = hw.values[i] < 0 ? -1 : hw.values[i] - m_hw_start.values[i];
+                add_phase(m_name, wall, cpu, trades, allocations, &hw);
+            } else {
+                add_phase(m_name, wall, cpu, trades, allocations, nullptr);
+            }
+        }
+    }
+
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+private:
+    const char* m_name;
+    const HwCounters* m_hw;
+    HwCounters::sample_t m_hw_start;
+    size_t m_trades;
+    size_t m_allocations;
+    std::chrono::steady_clock::time_point m_wall;
+    std::clock_t m_cpu;
+};
+
+// Write phases (in order of first occurrence) and counters as a JSON object.
+// With hardware counters, each phase also reports IPC and misses per trade priced; if they
+// could not be opened, the reason is reported instead. Latency histograms are included
+// when they are enabled.
+void write_json(std::ostream& os);
+
+} // namespace perf
+
+} // namespace minirisk
@@ -1,22 +1,33 @@
 #include "Global.h"
 #include "PortfolioUtils.h"
-#include "TradePayment.h"
-#include "TradeFXForward.h"
+#include "TradeTypes.h"
 #include "Macros.h"
+#include "PerfCounters.h"
+#include "Trace.h"
+#include "LatencyHistogram.h"
+#include "MappedFile.h"
+#include "SensitivityMatrix.h"
+#include "ReportWriter.h"
+#include "TaskScheduler.h"
+#include "Reduction.h"
 
 #include <numeric>
 #include <map>
 #include <set>
 #include <limits>
+#include <atomic>
+#include <cstring>
+#include <exception>
 
 namespace minirisk {
 
-void print_portfolio(const portfolio_t& portfolio)
+void print_portfolio(const portfolio_t& portfolio, std::ostream& os)
 {
     // Portfolio can be empty, which is valid (just prints nothing)
-    std::for_each(portfolio.begin(), portfolio.end(), [](auto& pt){ 
+    ReportWriter w(os);
+    std::for_each(portfolio.begin(), portfolio.end(), [&w](auto& pt){ 
         MYASSERT(pt.get() != nullptr, "Portfolio contains null trade pointer");
-        pt->print(std::cout); 
+        pt->print(w); 
     });
 }
 
@@ -39,6 +50,89 @@ std::vector<ppricer_t> get_pricers(const portfolio_t& portfolio, const std::stri
     return pricers;
 }
 
+std::vector<ppricer_t> get_native_pricers(const portfolio_t& portfolio)
+{
+    MYASSERT(!portfolio.empty(), "Portfolio cannot be empty");
+
+    std::vector<ppricer_t> pricers(portfolio.size());
+    std::transform( portfolio.begin(), portfolio.end(), pricers.begin()
+                  , [](auto &pt) -> ppricer_t {
+                      MYASSERT(pt.get() != nullptr, "Cannot create pricer for null trade");
+                      return pt->pricer("");
+                  } );
+    return pricers;
+}
+
+// Price the pricers [begin, end) of a batch of pricers of the same type. For a registered
+// (final) pricer type the call to price is not virtual.
+template <typename P>
+static void price_batch(const pricer_batch_t<P>& batch, size_t begin, size_t end, Market& mkt, const FixingDataServer* fds, portfolio_values_t& prices)
+{
+    for (size_t k = begin; k < end; ++k) {
+        auto& res = prices[batch.index[k]];
+        try {
+            res.first = batch.pricers[k]->price(mkt, fds);
+            res.second.clear();
+        } catch (const std::exception& e) {
+            perf::count(perf::pricing_errors);
+            res.first = std::numeric_limits<double>::quiet_NaN();
+            res.second = e.what();
+        }
+    }
+}
+
+// Price the pricers at positions [begin, end) of the batches taken one after the other
+static void price_range(const pricer_batches_t& batches, size_t begin, size_t end, Market& mkt, const FixingDataServer* fds, portfolio_values_t& prices)
+{
+    size_t offset = 0;
+    batches.for_each([&](const auto& batch) {
+        size_t lo = std::max(begin, offset);
+        size_t hi = std::min(end, offset + batch.size());
+        if (lo < hi)
+            price_batch(batch, lo - offset, hi - offset, mkt, fds, prices);
+        offset += batch.size();
+    });
+}
+
+// smallest block of trades priced by one task
+static const size_t pricing_grain = 64;
+
+// Price all trades into prices. The vector and its error messages are overwritten in place,
+// so that their memory is reused when the same vector is passed for several scenarios.
+// Blocks of trades are priced on the threads of the global scheduler, except when called
+// from one of its tasks (e.g. a bump scenario).
+static void compute_prices_into(const pricer_batches_t& batches, Market& mkt, const FixingDataServer* fds, portfolio_values_t& prices)
+{
+    trace::ScopedEvent event("compute_prices", "pricing");
+    perf::ScopedLatency latency(perf::lat_compute_prices);
+    perf::count(perf::pricing_calls, batches.size());
+    prices.resize(batches.size());
+
+    TaskScheduler& scheduler = TaskScheduler::global();
+    if (scheduler.n_threads() == 1 || TaskScheduler::in_task() || batches.size() <= pricing_grain) {
+        price_range(batches, 0, batches.size(), mkt, fds, prices);
+        return;
+    }
+
+    // The calling thread prices with mkt, the others with copies of it. The copies start
+    // without curves, as some curves refer to the market which built them. While mkt records
+    // dependencies, each copy records its own, added to those of mkt at the end.
+    std::vector<std::unique_ptr<Market>> markets(scheduler.n_threads());
+    std::vector<std::set<string>> deps(markets.size());
+    for (size_t w = 1; w < markets.size(); ++w) {
+        markets[w].reset(new Market(mkt));
+        markets[w]->clear();
+        markets[w]->record_dependencies(mkt.recording() ? &deps[w] : nullptr);
+    }
+    scheduler.parallel_for(batches.size(), pricing_grain, [&](unsigned w, size_t begin, size_t end) {
+        price_range(batches, begin, end, w ? *markets[w] : mkt, fds, prices);
+    });
+    for (size_t w = 1; w < markets.size(); ++w) {
+        mkt.merge_risk_factors(*markets[w]);
+        mkt.add_dependencies(deps[w]);
+    }
+}
+
 portfolio_values_t compute_prices(const std::vector<ppricer_t>& pricers, Market& mkt, const FixingDataServer* fds)
 {
     MYASSERT(!pricers.empty(), "Pricers vector cannot be empty");
@@ -48,35 +142,245 @@ portfolio_values_t compute_prices(const std::vector<ppricer_t>& pricers, Market&
         MYASSERT(pricers[i].get() != nullptr, "Pricer at index " << i << " is null");
     }
     
-    portfolio_values_t prices(pricers.size());
-    for (size_t i = 0; i < pricers.size(); ++i) {
-        try {
-            double price = pricers[i]->price(mkt, fds);
-            prices[i] = std::make_pair(price, "");
-        } catch (const std::exception& e) {
-            prices[i] = std::make_pair(std::numeric_limits<double>::quiet_NaN(), e.what());
+    portfolio_values_t prices;
+    compute_prices_into(pricer_batches_t(pricers), mkt, fds, prices);
+    return prices;
+}
+
+portfolio_values_t convert_prices(const std::vector<ppricer_t>& pricers, const portfolio_values_t& values, Market& mkt, const string& base_ccy)
+{
+    MYASSERT(pricers.size() == values.size(), "Pricers and values have different sizes: " << pricers.size() << " vs " << values.size());
+
+    const Ccy base(base_ccy);
+
+    // conversion rate (or error message) per trade currency, fetched once per call
+    std::map<Ccy, std::pair<double, string>> rates;
+
+    portfolio_values_t converted(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        Ccy ccy = pricers[i]->ccy();
+        if (std::isnan(values[i].first) || ccy == base) {
+            converted[i] = values[i];
+            continue;
         }
+        auto ins = rates.emplace(ccy, std::make_pair(0.0, ""));
+        if (ins.second) {
+            try {
+                ins.first->second.first = mkt.get_fx_spot_curve(fx_spot_name(ccy, base))->spot();
+            } catch (const std::exception& e) {
+                ins.first->second = std::make_pair(std::numeric_limits<double>::quiet_NaN(), e.what());
+            }
+        }
+        const auto& rate = ins.first->second;
+        converted[i] = std::isnan(rate.first)
+            ? rate
+            : std::make_pair(values[i].first * rate.first, string());
     }
-    return prices;
+    return converted;
+}
+
+// Sum of the values not in error, one position per trade (see Reduction.h), so that it
+// does not depend on the number of threads. Large portfolios are summed a few leaves per
+// task on the global scheduler.
+static double total_value(const portfolio_values_t& values)
+{
+    const size_t leaf_size = ReproducibleSum::leaf_size;
+    auto add = [](ReproducibleSum& s, const std::pair<double, string>& v) {
+        if (std::isnan(v.first))
+            s.skip();
+        else
+            s.add(v.first);
+    };
+
+    std::vector<double> leaves(values.size() / leaf_size);
+    TaskScheduler::global().parallel_for(leaves.size(), 16, [&](unsigned, size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            ReproducibleSum s;
+            for (size_t i = k * leaf_size; i < (k + 1) * leaf_size; ++i)
+                add(s, values[i]);
+            leaves[k] = s.value();
+        }
+    });
+
+    ReproducibleSum total;
+    for (double s : leaves)
+        total.add_leaf(s);
+    for (size_t i = leaves.size() * leaf_size; i < values.size(); ++i)
+        add(total, values[i]);
+    return total.value();
 }
 
 std::pair<double, std::vector<std::pair<size_t, string>>> portfolio_total(const portfolio_values_t& values)
 {
-    double total = 0.0;
     std::vector<std::pair<size_t, string>> errors;
     
     for (size_t i = 0; i < values.size(); ++i) {
         if (std::isnan(values[i].first)) {
             errors.push_back(std::make_pair(i, values[i].second));
-        } else {
-            total += values[i].first;
         }
     }
     
-    return std::make_pair(total, errors);
+    return std::make_pair(total_value(values), errors);
+}
+
+// Price the portfolio in the current state of mkt into res. With no base currencies the
+// prices are stored as computed, otherwise they are converted into each of the base currencies.
+// res is reused from one scenario to the next.
+static void scenario_prices(const std::vector<ppricer_t>& pricers, const pricer_batches_t& batches, Market& mkt, const FixingDataServer* fds, const std::vector<string>& base_ccys, std::vector<portfolio_values_t>& res)
+{
+    res.resize(std::max<size_t>(base_ccys.size(), 1));
+    if (base_ccys.empty()) {
+        compute_prices_into(batches, mkt, fds, res.front());
+        return;
+    }
+
+    portfolio_values_t prices;
+    compute_prices_into(batches, mkt, fds, prices);
+    for (size_t b = 0; b < base_ccys.size(); ++b)
+        res[b] = convert_prices(pricers, prices, mkt, base_ccys[b]);
+}
+
+// reusable buffers for the prices of the down and up scenarios
+struct scenario_buffers_t
+{
+    std::vector<portfolio_values_t> dn, up;
+};
+
+// finite difference per trade: central with the down scenario, forward with the base prices
+static portfolio_values_t finite_difference(const portfolio_values_t& pv_up, const portfolio_values_t& pv_dn, double denom)
+{
+    portfolio_values_t res(pv_up.size());
+    for (size_t i = 0; i < pv_up.size(); ++i) {
+        if (std::isnan(pv_up[i].first) || std::isnan(pv_dn[i].first)) {
+            // If either up or down bump is NaN, set result to NaN
+            string error_msg = std::isnan(pv_up[i].first) ? pv_up[i].second : pv_dn[i].second;
+            res[i] = std::make_pair(std::numeric_limits<double>::quiet_NaN(), error_msg);
+        } else {
+            double diff = (pv_up[i].first - pv_dn[i].first) / denom;
+            res[i] = std::make_pair(diff, "");
+        }
+    }
+    return res;
+}
+
+// dense results: one vector of values per risk factor
+typedef std::vector<std::pair<string, portfolio_values_t>> dense_sensitivities_t;
+
+static void add_factor(dense_sensitivities_t& res, const string& name, portfolio_values_t&& values)
+{
+    res.emplace_back(name, std::move(values));
+}
+
+static void add_factor(SensitivityMatrix& res, const string& name, portfolio_values_t&& values)
+{
+    res.add_factor(name, values);
+}
+
+// finite difference with respect to one risk factor, or a group of them bumped together (the
+// down bump is only used by central differences)
+struct scenario_t
+{
+    string name;
+    Market::vec_risk_factor_t dn;
+    Market::vec_risk_factor_t up;
+    Market::vec_risk_factor_t restore;
+    double denom;
+};
+
+// State of a thread running scenarios: a local copy of the Market object, because we will
+// modify it applying bumps. Note that the actual market objects are shared, as they are
+// referred to via pointers. The objects rebuilt for each scenario are allocated in an arena.
+struct scenario_worker_t
+{
+    explicit scenario_worker_t(const Market& mkt)
+        : tmpmkt(mkt)
+    {
+        tmpmkt.use_arena();
+    }
+
+    // Set the bumped values, restoring those of the previous scenario at the same time, so
+    // that the market objects are destroyed once per bump rather than once more to restore
+    void apply(const Market::vec_risk_factor_t& bump)
+    {
+        bumped.assign(restore.begin(), restore.end());
+        bumped.insert(bumped.end(), bump.begin(), bump.end());
+        tmpmkt.set_risk_factors(bumped);
+        restore.clear();
+    }
+
+    Market tmpmkt;
+    scenario_buffers_t buf;
+    Market::vec_risk_factor_t restore;  // values to restore before the next bump
+    Market::vec_risk_factor_t bumped;
+};
+
+// Reprice with the bumps of the scenario and store in res the finite difference (one entry
+// per base currency, or a single one when base_ccys is empty): central if base is null,
+// otherwise forward from the base prices
+static void bump_and_reprice(const std::vector<ppricer_t>& pricers, const pricer_batches_t& batches, scenario_worker_t& worker, const FixingDataServer* fds, const std::vector<string>& base_ccys
+    , const scenario_t& s, const std::vector<portfolio_values_t>* base, std::vector<portfolio_values_t>& res)
+{
+    trace::ScopedEvent event(s.name, "scenario");
+    scenario_buffers_t& buf = worker.buf;
+
+    if (base) {
+        // bump up and price
+        worker.apply(s.up);
+        scenario_prices(pricers, batches, worker.tmpmkt, fds, base_ccys, buf.up);
+    } else {
+        // bump down and price
+        worker.apply(s.dn);
+        scenario_prices(pricers, batches, worker.tmpmkt, fds, base_ccys, buf.dn);
+
+        // bump up (the same risk factors) and price
+        worker.apply(s.up);
+        scenario_prices(pricers, batches, worker.tmpmkt, fds, base_ccys, buf.up);
+    }
+    worker.restore = s.restore;
+
+    res.resize(buf.up.size());
+    for (size_t b = 0; b < res.size(); ++b)
+        res[b] = finite_difference(buf.up[b], base ? (*base)[b] : buf.dn[b], s.denom);
+}
+
+// Run the scenarios on the threads of the global scheduler, a wave of a few scenarios per
+// thread at a time, and append their results to res in the order of the scenarios. With
+// forward differences the portfolio is priced once in the unbumped market beforehand.
+template <typename R>
+static void run_scenarios(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds, const std::vector<string>& base_ccys
+    , const std::vector<scenario_t>& scenarios, bump_settings_t::scheme_t scheme, std::vector<R>& res)
+{
+    TaskScheduler& scheduler = TaskScheduler::global();
+    pricer_batches_t batches(pricers);
+    std::vector<std::unique_ptr<scenario_worker_t>> workers(scheduler.n_threads());
+
+    std::vector<portfolio_values_t> base;
+    if (scheme == bump_settings_t::forward && !scenarios.empty()) {
+        Market basemkt(mkt);
+        scenario_prices(pricers, batches, basemkt, fds, base_ccys, base);
+    }
+
+    const size_t wave = 4 * scheduler.n_threads();
+    std::vector<std::vector<portfolio_values_t>> diffs(wave);
+
+    for (auto& r : res)
+        r.reserve(scenarios.size());
+    for (size_t first = 0; first < scenarios.size(); first += wave) {
+        const size_t n = std::min(wave, scenarios.size() - first);
+        scheduler.parallel_for(n, 1, [&](unsigned w, size_t begin, size_t end) {
+            auto& worker = workers[w];
+            if (!worker)
+                worker.reset(new scenario_worker_t(mkt));
+            for (size_t i = begin; i < end; ++i)
+                bump_and_reprice(pricers, batches, *worker, fds, base_ccys, scenarios[first + i], base.empty() ? nullptr : &base, diffs[i]);
+        });
+        for (size_t i = 0; i < n; ++i)
+            for (size_t b = 0; b < res.size(); ++b)
+                add_factor(res[b], scenarios[first + i].name, std::move(diffs[i][b]));
+    }
 }
 
-std::vector<std::pair<string, portfolio_values_t>> compute_pv01_parallel(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds)
+static void check_pricers(const std::vector<ppricer_t>& pricers)
 {
     MYASSERT(!pricers.empty(), "Pricers vector cannot be empty");
     
@@ -84,10 +388,24 @@ std::vector<std::pair<string, portfolio_values_t>> compute_pv01_parallel(const s
     for (size_t i = 0; i < pricers.size(); ++i) {
         MYASSERT(pricers[i].get() != nullptr, "Pricer at index " << i << " is null");
     }
+}
+
+// denominator of the finite difference for a bump of size h
+static double fd_denom(bump_settings_t::scheme_t scheme, double h)
+{
+    return scheme == bump_settings_t::central ? 2.0 * h : h;
+}
+
+template <typename R>
+static std::vector<R> pv01_parallel(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds, const std::vector<string>& base_ccys, const bump_settings_t& bumps)
+{
+    check_pricers(pricers);
     
-    std::vector<std::pair<string, portfolio_values_t>> pv01;  // PV01 per trade
+    // PV01 per trade, per base currency
+    std::vector<R> pv01(std::max<size_t>(base_ccys.size(), 1));
 
-    const double bump_size = 0.01 / 100; // 1bp
+    const double bump_size = bumps.ir_bump;
+    const bool central = bumps.scheme == bump_settings_t::central;
 
     // Get all IR tenor risk factors and group them by currency
     auto all_ir = mkt.get_risk_factors("IR\\.[0-9]+[DWMY]\\.[A-Z]{3}$");
@@ -100,198 +418,224 @@ std::vector<std::pair<string, portfolio_values_t>> compute_pv01_parallel(const s
         by_currency[ccy].push_back(rf);
     }
 
-    // Filter to only include currencies that are actually used in the portfolio
-    // Dynamically determine currencies from the risk factors available
-    std::set<string> portfolio_currencies;
-    for (const auto& rf : all_ir) {
-        // Extract currency from risk factor name (e.g., "IR.2Y.USD" -> "USD")
-        string ccy = rf.first.substr(rf.first.length() - 3, 3);
-        portfolio_currencies.insert(ccy);
-    }
-
-    // Make a local copy of the Market object, because we will modify it applying bumps
-    // Note that the actual market objects are shared, as they are referred to via pointers
-    Market tmpmkt(mkt);
-
-    pv01.reserve(portfolio_currencies.size());
-    for (const string& ccy : portfolio_currencies) {
-        auto it = by_currency.find(ccy);
-        if (it == by_currency.end()) continue; // Skip if no risk factors for this currency
+    std::vector<scenario_t> scenarios;
+    scenarios.reserve(by_currency.size());
+    for (const auto& c : by_currency) {
+        const auto& all = c.second;
         
-        const auto& all = it->second;
-        
-        // Build bumped set: apply same bump to every tenor for that currency
-        std::vector<std::pair<string, double>> bumped; bumped.reserve(all.size());
-        pv01.push_back(std::make_pair("IR." + ccy, portfolio_values_t(pricers.size())));
-
-        // bump down
-        bumped.clear();
-        for (const auto& rf : all) bumped.emplace_back(rf.first, rf.second - bump_size);
-        tmpmkt.set_risk_factors(bumped);
-        auto pv_dn = compute_prices(pricers, tmpmkt, fds);
-
-        // bump up
-        bumped.clear();
-        for (const auto& rf : all) bumped.emplace_back(rf.first, rf.second + bump_size);
-        tmpmkt.set_risk_factors(bumped);
-        auto pv_up = compute_prices(pricers, tmpmkt, fds);
-
-        // restore
-        tmpmkt.set_risk_factors(all);
-
-        // central difference per trade
-        double dr = 2.0 * bump_size;
-        for (size_t i = 0; i < pv_up.size(); ++i) {
-            if (std::isnan(pv_up[i].first) || std::isnan(pv_dn[i].first)) {
-                // If either up or down bump is NaN, set result to NaN
-                string error_msg = std::isnan(pv_up[i].first) ? pv_up[i].second : pv_dn[i].second;
-                pv01.back().second[i] = std::make_pair(std::numeric_limits<double>::quiet_NaN(), error_msg);
-            } else {
-                double diff = (pv_up[i].first - pv_dn[i].first) / dr;
-                pv01.back().second[i] = std::make_pair(diff, "");
-            }
+        // Build bumped sets: apply same bump to every tenor for that currency
+        scenario_t s{ "IR." + c.first, {}, {}, all, fd_denom(bumps.scheme, bump_size) };
+        s.up.reserve(all.size());
+        for (const auto& rf : all) {
+            if (central)
+                s.dn.emplace_back(rf.first, rf.second - bump_size);
+            s.up.emplace_back(rf.first, rf.second + bump_size);
         }
+        scenarios.push_back(std::move(s));
     }
 
+    run_scenarios(pricers, mkt, fds, base_ccys, scenarios, bumps.scheme, pv01);
     return pv01;
 }
 
-std::vector<std::pair<string, portfolio_values_t>> compute_pv01_bucketed(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds)
+template <typename R>
+static std::vector<R> pv01_bucketed(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds, const std::vector<string>& base_ccys, const bump_settings_t& bumps)
 {
-    MYASSERT(!pricers.empty(), "Pricers vector cannot be empty");
+    check_pricers(pricers);
     
-    // Validate all pricers are non-null
-    for (size_t i = 0; i < pricers.size(); ++i) {
-        MYASSERT(pricers[i].get() != nullptr, "Pricer at index " << i << " is null");
-    }
-    
-    std::vector<std::pair<string, portfolio_values_t>> pv01;  // PV01 per trade
+    // PV01 per trade, per base currency
+    std::vector<R> pv01(std::max<size_t>(base_ccys.size(), 1));
 
-    const double bump_size = 0.01 / 100; // 1bp
+    const double bump_size = bumps.ir_bump;
+    const bool central = bumps.scheme == bump_settings_t::central;
 
     // Find all individual tenor IR points (e.g., IR.1M.USD, IR.2Y.EUR, ...)
     auto all = mkt.get_risk_factors("IR\\.[0-9]+[DWMY]\\.[A-Z]{3}$");
 
-    // Filter to only include currencies that are actually used in the portfolio
-    // Dynamically determine currencies from the risk factors available
-    std::set<string> portfolio_currencies;
+    std::vector<scenario_t> scenarios;
+    scenarios.reserve(all.size());
     for (const auto& d : all) {
-        // Extract currency from risk factor name (e.g., "IR.2Y.USD" -> "USD")
-        string ccy = d.first.substr(d.first.length() - 3, 3);
-        portfolio_currencies.insert(ccy);
+        Market::vec_risk_factor_t dn;
+        if (central)
+            dn.emplace_back(d.first, d.second - bump_size);
+        Market::vec_risk_factor_t up(1, std::make_pair(d.first, d.second + bump_size));
+        Market::vec_risk_factor_t restore(1, d);
+        scenarios.push_back(scenario_t{ d.first, dn, up, restore, fd_denom(bumps.scheme, bump_size) });
     }
 
-    Market tmpmkt(mkt);
-    
-    // Filter the risk factors to only include those for portfolio currencies
-    std::vector<std::pair<string, double>> filtered_all;
-    for (const auto& d : all) {
-        // Extract currency from risk factor name (e.g., "IR.2Y.USD" -> "USD")
-        string ccy = d.first.substr(d.first.length() - 3, 3);
-        if (portfolio_currencies.find(ccy) != portfolio_currencies.end()) {
-            filtered_all.push_back(d);
-        }
-    }
+    run_scenarios(pricers, mkt, fds, base_ccys, scenarios, bumps.scheme, pv01);
+    return pv01;
+}
+
+template <typename R>
+static std::vector<R> fx_delta(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds, const std::vector<string>& base_ccys, const bump_settings_t& bumps)
+{
+    check_pricers(pricers);
     
-    pv01.reserve(filtered_all.size());
+    // FX delta per trade, per base currency
+    std::vector<R> delta(std::max<size_t>(base_ccys.size(), 1));
 
-    for (const auto& d : filtered_all) {
-        std::vector<std::pair<string, double>> bumped(1, d);
-        pv01.push_back(std::make_pair(d.first, portfolio_values_t(pricers.size())));
+    // relative bump
+    const double rel_bump = bumps.fx_rel_bump;
+    const bool central = bumps.scheme == bump_settings_t::central;
 
-        // bump down and price
-        bumped[0].second = d.second - bump_size;
-        tmpmkt.set_risk_factors(bumped);
-        auto pv_dn = compute_prices(pricers, tmpmkt, fds);
+    // list all FX spot risk factors quoted vs USD (keys are like FX.SPOT.CCY)
+    // We only consider those that are cached/known via get_risk_factors
+    auto all_fx = mkt.get_risk_factors("FX\\.SPOT\\.[A-Z]{3}$");
 
-        // bump up and price
-        bumped[0].second = d.second + bump_size;
-        tmpmkt.set_risk_factors(bumped);
-        auto pv_up = compute_prices(pricers, tmpmkt, fds);
+    std::vector<scenario_t> scenarios;
+    scenarios.reserve(all_fx.size());
+    for (const auto& d : all_fx) {
+        const string& name = d.first;      // e.g. FX.SPOT.EUR
+        const double spot0 = d.second;     // current value
 
-        // restore
-        bumped[0].second = d.second;
-        tmpmkt.set_risk_factors(bumped);
+        // relative bump
+        Market::vec_risk_factor_t dn;
+        if (central)
+            dn.emplace_back(name, spot0 * (1.0 - rel_bump));
+        Market::vec_risk_factor_t up(1, std::make_pair(name, spot0 * (1.0 + rel_bump)));
+        Market::vec_risk_factor_t restore(1, d);
 
-        // central difference
-        double dr = 2.0 * bump_size;
-        for (size_t i = 0; i < pv_up.size(); ++i) {
-            if (std::isnan(pv_up[i].first) || std::isnan(pv_dn[i].first)) {
-                // If either up or down bump is NaN, set result to NaN
-                string error_msg = std::isnan(pv_up[i].first) ? pv_up[i].second : pv_dn[i].second;
-                pv01.back().second[i] = std::make_pair(std::numeric_limits<double>::quiet_NaN(), error_msg);
-            } else {
-                double diff = (pv_up[i].first - pv_dn[i].first) / dr;
-                pv01.back().second[i] = std::make_pair(diff, "");
-            }
-        }
+        // divide by 2*spot0*rel_bump (central) or spot0*rel_bump (forward) to get dPV/dSpot
+        scenarios.push_back(scenario_t{ name, dn, up, restore, fd_denom(bumps.scheme, spot0 * rel_bump) });
     }
 
-    return pv01;
+    run_scenarios(pricers, mkt, fds, base_ccys, scenarios, bumps.scheme, delta);
+    return delta;
 }
 
+std::vector<std::pair<string, portfolio_values_t>> compute_pv01_parallel(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds, const bump_settings_t& bumps)
+{
+    return pv01_parallel<dense_sensitivities_t>(pricers, mkt, fds, {}, bumps).front();
+}
 
-std::vector<std::pair<string, portfolio_values_t>> compute_fx_delta(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds)
+std::vector<std::pair<string, portfolio_values_t>> compute_pv01_bucketed(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds, const bump_settings_t& bumps)
 {
-    MYASSERT(!pricers.empty(), "Pricers vector cannot be empty");
-    
-    // Validate all pricers are non-null
-    for (size_t i = 0; i < pricers.size(); ++i) {
-        MYASSERT(pricers[i].get() != nullptr, "Pricer at index " << i << " is null");
+    return pv01_bucketed<dense_sensitivities_t>(pricers, mkt, fds, {}, bumps).front();
+}
+
+std::vector<std::pair<string, portfolio_values_t>> compute_fx_delta(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds, const bump_settings_t& bumps)
+{
+    return fx_delta<dense_sensitivities_t>(pricers, mkt, fds, {}, bumps).front();
+}
+
+std::vector<portfolio_values_t> compute_prices_multi(const std::vector<ppricer_t>& pricers, Market& mkt, const FixingDataServer* fds, const std::vector<string>& base_ccys)
+{
+    MYASSERT(!base_ccys.empty(), "Base currencies cannot be empty");
+    check_pricers(pricers);
+    std::vector<portfolio_values_t> res;
+    scenario_prices(pricers, pricer_batches_t(pricers), mkt, fds, base_ccys, res);
+    return res;
+}
+
+// records the dependencies of a market while in scope
+struct dependency_recorder_t
+{
+    dependency_recorder_t(Market& mkt, std::set<string>& deps)
+        : m_mkt(mkt)
+    {
+        MYASSERT(!mkt.recording(), "The market is already recording its dependencies");
+        mkt.record_dependencies(&deps);
     }
-    
-    std::vector<std::pair<string, portfolio_values_t>> fx_delta;
+    ~dependency_recorder_t() { m_mkt.record_dependencies(nullptr); }
 
-    // relative bump of 0.1%
-    const double rel_bump = 0.1 / 100.0;
+    Market& m_mkt;
+};
 
-    // list all FX spot risk factors quoted vs USD (keys are like FX.SPOT.CCY)
-    // We only consider those that are cached/known via get_risk_factors
-    auto all_fx = mkt.get_risk_factors("FX\\.SPOT\\.[A-Z]{3}$");
+std::vector<std::vector<string>> required_risk_factors(const std::vector<ppricer_t>& pricers, Market& mkt, const FixingDataServer* fds, const std::vector<string>& base_ccys, std::vector<portfolio_values_t>* prices)
+{
+    check_pricers(pricers);
 
-    // Make a local copy of the Market because we'll apply bumps
-    Market tmpmkt(mkt);
+    std::set<string> priced;
+    portfolio_values_t values;
+    {
+        dependency_recorder_t recorder(mkt, priced);
+        compute_prices_into(pricer_batches_t(pricers), mkt, fds, values);
+    }
 
-    fx_delta.reserve(all_fx.size());
-    for (const auto& d : all_fx) {
-        const string& name = d.first;      // e.g. FX.SPOT.EUR
-        const double spot0 = d.second;     // current value
+    std::vector<std::vector<string>> res;
+    std::vector<portfolio_values_t> converted;
+    if (base_ccys.empty()) {
+        res.emplace_back(priced.begin(), priced.end());
+        converted.push_back(std::move(values));
+    }
+    for (const auto& base_ccy : base_ccys) {
+        std::set<string> deps(priced);
+        {
+            dependency_recorder_t recorder(mkt, deps);
+            converted.push_back(convert_prices(pricers, values, mkt, base_ccy));
+        }
+        res.emplace_back(deps.begin(), deps.end());
+    }
+    if (prices)
+        *prices = std::move(converted);
+    return res;
+}
 
-        // central relative bump
-        const double bump_size_dn = spot0 * (1.0 - rel_bump);
-        const double bump_size_up = spot0 * (1.0 + rel_bump);
+std::vector<std::vector<std::pair<string, portfolio_values_t>>> compute_pv01_parallel_multi(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds, const std::vector<string>& base_ccys, const bump_settings_t& bumps)
+{
+    MYASSERT(!base_ccys.empty(), "Base currencies cannot be empty");
+    return pv01_parallel<dense_sensitivities_t>(pricers, mkt, fds, base_ccys, bumps);
+}
 
-        std::vector<std::pair<string, double>> bumped(1, d);
-        fx_delta.push_back(std::make_pair(name, portfolio_values_t(pricers.size())));
+std::vector<std::vector<std::pair<string, portfolio_values_t>>> compute_pv01_bucketed_multi(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds, const std::vector<string>& base_ccys, const bump_settings_t& bumps)
+{
+    MYASSERT(!base_ccys.empty(), "Base currencies cannot be empty");
+    return pv01_bucketed<dense_sensitivities_t>(pricers, mkt, fds, base_ccys, bumps);
+}
 
-        // bump down and price
-        bumped[0].second = bump_size_dn;
-        tmpmkt.set_risk_factors(bumped);
-        auto pv_dn = compute_prices(pricers, tmpmkt, fds);
+std::vector<std::vector<std::pair<string, portfolio_values_t>>> compute_fx_delta_multi(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds, const std::vector<string>& base_ccys, const bump_settings_t& bumps)
+{
+    MYASSERT(!base_ccys.empty(), "Base currencies cannot be empty");
+    return fx_delta<dense_sensitivities_t>(pricers, mkt, fds, base_ccys, bumps);
+}
 
-        // bump up and price
-        bumped[0].second = bump_size_up;
-        tmpmkt.set_risk_factors(bumped);
-        auto pv_up = compute_prices(pricers, tmpmkt, fds);
+std::vector<SensitivityMatrix> compute_pv01_bucketed_sparse(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds, const std::vector<string>& base_ccys, const bump_settings_t& bumps)
+{
+    return pv01_bucketed<SensitivityMatrix>(pricers, mkt, fds, base_ccys, bumps);
+}
 
-        // restore
-        bumped[0].second = spot0;
-        tmpmkt.set_risk_factors(bumped);
+std::vector<SensitivityMatrix> compute_pv01_parallel_sparse(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds, const std::vector<string>& base_ccys, const bump_settings_t& bumps)
+{
+    return pv01_parallel<SensitivityMatrix>(pricers, mkt, fds, base_ccys, bumps);
+}
+
+std::vector<SensitivityMatrix> compute_fx_delta_sparse(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds, const std::vector<string>& base_ccys, const bump_settings_t& bumps)
+{
+    return fx_delta<SensitivityMatrix>(pricers, mkt, fds, base_ccys, bumps);
+}
 
-        // central difference per trade: divide by 2*spot0*rel_bump to get dPV/dSpot
-        const double denom = (2.0 * spot0 * rel_bump);
-        for (size_t i = 0; i < pv_up.size(); ++i) {
-            if (std::isnan(pv_up[i].first) || std::isnan(pv_dn[i].first)) {
-                string error_msg = std::isnan(pv_up[i].first) ? pv_up[i].second : pv_dn[i].second;
-                fx_delta.back().second[i] = std::make_pair(std::numeric_limits<double>::quiet_NaN(), error_msg);
-            } else {
-                double diff = (pv_up[i].first - pv_dn[i].first) / denom;
-                fx_delta.back().second[i] = std::make_pair(diff, "");
+std::vector<SensitivityMatrix> pv01_parallel_from_bucketed(const std::vector<SensitivityMatrix>& bucketed)
+{
+    std::vector<SensitivityMatrix> res(bucketed.size());
+    for (size_t b = 0; b < bucketed.size(); ++b) {
+        const SensitivityMatrix& m = bucketed[b];
+
+        // tenors by currency (e.g. "IR.2Y.USD" -> "USD"), in the order of the bucketed factors
+        std::map<string, std::vector<size_t>> by_currency;
+        for (size_t f = 0; f < m.n_factors(); ++f) {
+            const string& name = m.factor(f);
+            by_currency[name.substr(name.length() - 3, 3)].push_back(f);
+        }
+
+        res[b].reserve(by_currency.size());
+        for (const auto& c : by_currency) {
+            portfolio_values_t sum(m.n_trades(), std::make_pair(0.0, string()));
+            for (size_t f : c.second) {
+                for (size_t k = m.row_begin(f); k < m.row_end(f); ++k) {
+                    auto& v = sum[m.trade(k)];
+                    if (std::isnan(v.first))
+                        continue;  // first error kept
+                    if (std::isnan(m.value(k)))
+                        v = std::make_pair(m.value(k), m.error(k));
+                    else
+                        v.first += m.value(k);
+                }
             }
+            res[b].add_factor("IR." + c.first, sum);
         }
     }
-
-    return fx_delta;
+    return res;
 }
 
 ptrade_t load_trade(my_ifstream& is)
@@ -303,11 +647,8 @@ ptrade_t load_trade(my_ifstream& is)
     guid_t id;
     is >> id;
 
-    if (id == TradePayment::m_id)
-        p.reset(new TradePayment);
-    else if (id == TradeFXForward::m_id)
-        p.reset(new TradeFXForward);
-    else
+    p = new_trade(id);
+    if (!p)
         THROW("Unknown trade type:" << id);
 
     p->load(is);
@@ -325,6 +666,8 @@ void save_portfolio(const string& filename, const std::vector<ptrade_t>& portfol
         MYASSERT(portfolio[i].get() != nullptr, "Portfolio entry at index " << i << " is null");
     }
     
+    trace::ScopedEvent event("save_portfolio", "io", filename);
+
     // test saving to file
     my_ofstream of(filename);
     for( const auto& pt : portfolio) {
@@ -338,6 +681,8 @@ std::vector<ptrade_t> load_portfolio(const string& filename)
 {
     MYASSERT(!filename.empty(), "Filename cannot be empty");
     
+    trace::ScopedEvent event("load_portfolio", "io", filename);
+
     std::vector<ptrade_t> portfolio;
 
     // test reloading the portfolio
@@ -353,35 +698,173 @@ std::vector<ptrade_t> load_portfolio(const string& filename)
     return portfolio;
 }
 
-void print_price_vector(const string& name, const portfolio_values_t& values)
+// Lines of a portfolio file handled by one task of the parallel loader
+struct load_chunk_t
 {
-    auto total_result = portfolio_total(values);
-    double total = total_result.first;
-    auto errors = total_result.second;
-    
-    std::cout
+    const char* begin;
+    const char* end;
+    size_t n_lines;             // lines before the end of the chunk or the first empty line
+    bool has_empty_line;        // an empty line ends the portfolio, as in load_portfolio
+    size_t first;               // position of the first trade of the chunk in the portfolio
+    std::exception_ptr error;   // first error of the chunk, which stops its parsing
+};
+
+// end of the line starting at p
+static const char* end_of_line(const char* p, const char* end)
+{
+    const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    return eol ? eol : end;
+}
+
+std::vector<ptrade_t> load_portfolio_parallel(const string& filename)
+{
+    MYASSERT(!filename.empty(), "Filename cannot be empty");
+
+    trace::ScopedEvent event("load_portfolio", "io", filename);
+
+    TaskScheduler& scheduler = TaskScheduler::global();
+
+    MappedFile file(filename);
+    const char* data = file.data();
+    const char* end = data + file.size();
+
+    // split the file in chunks of whole lines, a few per thread so that they balance out
+    const size_t min_chunk_size = 1 << 20;
+    const size_t n_chunks = std::max<size_t>(1, std::min<size_t>(4 * scheduler.n_threads(), file.size() / min_chunk_size));
+    std::vector<load_chunk_t> chunks;
+    chunks.reserve(n_chunks);
+    for (size_t i = 1, pos = 0; i <= n_chunks && data + pos < end; ++i) {
+        const char* q = i == n_chunks ? end : end_of_line(data + std::max(pos, file.size() * i / n_chunks), end);
+        if (q < end)
+            ++q; // include the new line
+        chunks.push_back(load_chunk_t{ data + pos, q, 0, false, 0, nullptr });
+        pos = q - data;
+    }
+
+    // count the lines of each chunk
+    scheduler.parallel_for(chunks.size(), 1, [&chunks](unsigned, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            load_chunk_t& c = chunks[i];
+            for (const char* p = c.begin; p < c.end; ) {
+                const char* eol = end_of_line(p, c.end);
+                if (eol == p) {
+                    c.has_empty_line = true;
+                    break;
+                }
+                ++c.n_lines;
+                p = eol + 1;
+            }
+        }
+    });
+
+    // place the chunks in the portfolio, up to the first empty line
+    size_t n_trades = 0;
+    for (auto& c : chunks) {
+        c.first = n_trades;
+        n_trades += c.n_lines;
+        if (c.has_empty_line) {
+            chunks.resize(&c - chunks.data() + 1);
+            break;
+        }
+    }
+
+    // parse, giving up on the lines after a known error
+    std::vector<ptrade_t> portfolio(n_trades);
+    std::atomic<size_t> first_error(n_trades);
+    scheduler.parallel_for(chunks.size(), 1, [&chunks, &portfolio, &first_error](unsigned, size_t begin, size_t end) {
+        my_ifstream is;
+        string line;
+        for (size_t i = begin; i < end; ++i) {
+            load_chunk_t& c = chunks[i];
+            const char* p = c.begin;
+            for (size_t k = 0; k < c.n_lines && c.first + k < first_error.load(std::memory_order_relaxed); ++k) {
+                const char* eol = end_of_line(p, c.end);
+                line.assign(p, eol);
+                p = eol + 1;
+                try {
+                    is.set_line(line);
+                    portfolio[c.first + k] = load_trade(is);
+                } catch (...) {
+                    c.error = std::current_exception();
+                    size_t e = first_error.load(std::memory_order_relaxed);
+                    while (c.first + k < e && !first_error.compare_exchange_weak(e, c.first + k, std::memory_order_relaxed))
+                        ;
+                    break;
+                }
+            }
+        }
+    });
+
+    // the first error in file order is the one the serial loader would throw
+    for (const auto& c : chunks)
+        if (c.error)
+            std::rethrow_exception(c.error);
+
+    return portfolio;
+}
+
+PortfolioReader::PortfolioReader(const string& filename)
+    : m_is(filename)
+    , m_done(false)
+    , m_position(0)
+{
+}
+
+bool PortfolioReader::read(size_t max_trades, portfolio_t& trades)
+{
+    MYASSERT(max_trades > 0, "Block size cannot be zero");
+    trades.clear();
+    while (!m_done && trades.size() < max_trades) {
+        if (!m_is.read_line()) {
+            m_done = true;
+            break;
+        }
+        trades.push_back(load_trade(m_is));
+    }
+    m_position += trades.size();
+    return !trades.empty();
+}
+
+ptrade_t parse_trade(const string& line)
+{
+    my_ifstream is;
+    MYASSERT(is.set_line(line), "Empty trade line");
+    return load_trade(is);
+}
+
+void print_price_vector(const string& name, const portfolio_values_t& values, std::ostream& os)
+{
+    // total and number of errors, as portfolio_total (without listing the errors)
+    const double total = total_value(values);
+    size_t errors = 0;
+    for (const auto& v : values)
+        if (std::isnan(v.first))
+            ++errors;
+
+    ReportWriter w(os);
+    w
         << "========================\n"
         << name << ":\n"
         << "========================\n"
         << "Total:  " << total << "\n";
     
-    if (!errors.empty()) {
-        std::cout << "Errors: " << errors.size() << "\n";
+    if (errors > 0) {
+        w << "Errors: " << errors << "\n";
     }
     
-    std::cout << "\n========================\n";
+    w << "\n========================\n";
 
     for (size_t i = 0, n = values.size(); i < n; ++i) {
-        std::cout << std::setw(5) << i << ": ";
+        w.right(i, 5) << ": ";
         if (std::isnan(values[i].first)) {
-            std::cout << values[i].second;
+            w << values[i].second;
         } else {
-            std::cout << values[i].first;
+            w << values[i].first;
         }
-        std::cout << "\n";
+        w << '\n';
     }
 
-    std::cout << "========================\n\n";
+    w << "========================\n\n";
 }
 
 } // namespace minirisk
@@ -9,29 +9,82 @@ namespace minirisk {
 
 struct Market;
 struct FixingDataServer;
+struct SensitivityMatrix;
 
 typedef std::vector<std::pair<double, string>> portfolio_values_t;
 
+// Finite difference scheme and bump sizes of the sensitivity functions
+struct bump_settings_t
+{
+    // central: (PV(x + h) - PV(x - h)) / 2h, two repricings per risk factor
+    // forward: (PV(x + h) - PV(x)) / h, one repricing per risk factor and one of the base
+    enum scheme_t { central, forward };
+
+    scheme_t scheme = central;
+    double ir_bump = 0.01 / 100;        // absolute bump of the IR rates (1bp)
+    double fx_rel_bump = 0.1 / 100;     // relative bump of the FX spots (0.1%)
+};
+
 // get pricer for each trade with configuration (e.g., base currency)
 std::vector<ppricer_t> get_pricers(const portfolio_t& portfolio, const std::string& configuration);
 
+// get pricer for each trade pricing in the trade own currency (see the *_multi functions below)
+std::vector<ppricer_t> get_native_pricers(const portfolio_t& portfolio);
+
 // compute prices
 portfolio_values_t compute_prices(const std::vector<ppricer_t>& pricers, Market& mkt, const FixingDataServer* fds);
 
+// convert prices expressed in the currency of each pricer into base_ccy, using the FX spots of mkt
+portfolio_values_t convert_prices(const std::vector<ppricer_t>& pricers, const portfolio_values_t& values, Market& mkt, const string& base_ccy);
+
 // compute the cumulative book value
 std::pair<double, std::vector<std::pair<size_t, string>>> portfolio_total(const portfolio_values_t& values);
 
+// Risk factors the prices of the pricers depend on, sorted by name: those accessed to price
+// them in mkt and, for each base currency, to convert the prices into it (one list per base
+// currency, or a single one with empty base_ccys). As mkt fetches risk factors on demand, these
+// are the only ones fetched from the market data server, hence the ones the sensitivity
+// functions below bump. The prices are stored in prices if not null, as compute_prices_multi
+// (or compute_prices with empty base_ccys) would return them.
+std::vector<std::vector<string>> required_risk_factors(const std::vector<ppricer_t>& pricers, Market& mkt, const FixingDataServer* fds, const std::vector<string>& base_ccys = {}, std::vector<portfolio_values_t>* prices = nullptr);
+
+// The sensitivity functions below bump the risk factors cached in mkt, by default with central
+// differences and the bump sizes of bump_settings_t
+//
 // Compute PV01 Parallel: sensitivity to parallel shift of the yield curve per currency
-// Use central differences, absolute bump of 0.01%
-std::vector<std::pair<string, portfolio_values_t>> compute_pv01_parallel(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds);
+// Absolute bump of the IR rates (0.01% by default)
+std::vector<std::pair<string, portfolio_values_t>> compute_pv01_parallel(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds, const bump_settings_t& bumps = bump_settings_t());
 
 // Compute PV01 Bucketed: sensitivity to each individual yield curve point (tenor)
-// Use central differences, absolute bump of 0.01%
-std::vector<std::pair<string, portfolio_values_t>> compute_pv01_bucketed(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds);
+// Absolute bump of the IR rates (0.01% by default)
+std::vector<std::pair<string, portfolio_values_t>> compute_pv01_bucketed(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds, const bump_settings_t& bumps = bump_settings_t());
 
 // Compute FX Delta: sensitivity to FX spot rates quoted against USD
-// Use central differences, relative bump of 0.1%
-std::vector<std::pair<string, portfolio_values_t>> compute_fx_delta(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds);
+// Relative bump of the FX spots (0.1% by default)
+std::vector<std::pair<string, portfolio_values_t>> compute_fx_delta(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds, const bump_settings_t& bumps = bump_settings_t());
+
+// Multi base currency versions of the functions above: the portfolio is priced and bumped once
+// with native pricers, and each scenario is converted into every base currency with the FX spots
+// of the same (bumped) market, so that FX delta includes the effect of the conversion.
+// Results are indexed as base_ccys.
+std::vector<portfolio_values_t> compute_prices_multi(const std::vector<ppricer_t>& pricers, Market& mkt, const FixingDataServer* fds, const std::vector<string>& base_ccys);
+std::vector<std::vector<std::pair<string, portfolio_values_t>>> compute_pv01_parallel_multi(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds, const std::vector<string>& base_ccys, const bump_settings_t& bumps = bump_settings_t());
+std::vector<std::vector<std::pair<string, portfolio_values_t>>> compute_pv01_bucketed_multi(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds, const std::vector<string>& base_ccys, const bump_settings_t& bumps = bump_settings_t());
+std::vector<std::vector<std::pair<string, portfolio_values_t>>> compute_fx_delta_multi(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds, const std::vector<string>& base_ccys, const bump_settings_t& bumps = bump_settings_t());
+
+// Sparse versions of the sensitivity functions above (see SensitivityMatrix.h). The results are
+// stored as each risk factor is computed, so that the dense vectors are never all in memory.
+// With empty base_ccys a single matrix is returned in the currency of the pricers, otherwise
+// there is one matrix per base currency, as in the *_multi functions.
+std::vector<SensitivityMatrix> compute_pv01_bucketed_sparse(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds, const std::vector<string>& base_ccys = {}, const bump_settings_t& bumps = bump_settings_t());
+std::vector<SensitivityMatrix> compute_pv01_parallel_sparse(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds, const std::vector<string>& base_ccys = {}, const bump_settings_t& bumps = bump_settings_t());
+std::vector<SensitivityMatrix> compute_fx_delta_sparse(const std::vector<ppricer_t>& pricers, const Market& mkt, const FixingDataServer* fds, const std::vector<string>& base_ccys = {}, const bump_settings_t& bumps = bump_settings_t());
+
+// PV01 parallel of each currency as the sum of the PV01 bucketed of its tenors, without
+// repricing. As a parallel shift is the sum of the shifts of each tenor, it is the same as
+// compute_pv01_parallel_sparse up to the finite difference error, which is negligible for
+// products (nearly) linear in the curve. A trade in error for a tenor is in error.
+std::vector<SensitivityMatrix> pv01_parallel_from_bucketed(const std::vector<SensitivityMatrix>& bucketed);
 
 // save portfolio to file
 void save_portfolio(const string& filename, const std::vector<ptrade_t>& portfolio);
@@ -39,11 +92,37 @@ void save_portfolio(const string& filename, const std::vector<ptrade_t>& portfol
 // load portfolio from file
 std::vector<ptrade_t>  load_portfolio(const string& filename);
 
+// Same as load_portfolio, parsing the memory mapped file in chunks of lines on the global
+// TaskScheduler. Trades are in file order and, on error, the exception thrown is the one
+// load_portfolio throws for the first bad line.
+std::vector<ptrade_t>  load_portfolio_parallel(const string& filename);
+
+// Reads a portfolio file a block of trades at a time, for portfolios too large to be loaded
+// at once. Blocks follow the file order and stop where load_portfolio stops.
+struct PortfolioReader
+{
+    explicit PortfolioReader(const string& filename);
+
+    // read up to max_trades trades into trades; returns false when there are no more trades
+    bool read(size_t max_trades, portfolio_t& trades);
+
+    // number of trades read so far
+    size_t position() const { return m_position; }
+
+private:
+    my_ifstream m_is;
+    bool m_done;
+    size_t m_position;
+};
+
+// load a single trade from a line in the portfolio file format
+ptrade_t parse_trade(const string& line);
+
 // print portfolio to cout
-void print_portfolio(const portfolio_t& portfolio);
+void print_portfolio(const portfolio_t& portfolio, std::ostream& os = std::cout);
 
 // print portfolio to cout
-void print_price_vector(const string& name, const portfolio_values_t& values);
+void print_price_vector(const string& name, const portfolio_values_t& values, std::ostream& os = std::cout);
 
 
 } // namespace minirisk
@@ -4,6 +4,7 @@
 #include "CurveFXForward.h"
 #include "CurveFXSpot.h"
 #include "Global.h"
+#include "LatencyHistogram.h"
 
 namespace minirisk {
 
@@ -14,13 +15,15 @@ PricerFXForward::PricerFXForward(const TradeFXForward& trd, const std::string& b
     , m_strike(trd.strike())
     , m_fixing_date(trd.fixing_date())
     , m_settle_date(trd.settle_date())
-    , m_base_ccy(base_ccy)
-    , m_fx_pair(m_ccy2 == base_ccy ? "" : fx_spot_name(m_ccy2, base_ccy))
+    , m_base_ccy(base_ccy.empty() ? trd.ccy2() : Ccy(base_ccy))
+    , m_fx_pair(m_ccy2 == m_base_ccy ? "" : fx_spot_name(m_ccy2, m_base_ccy))
 {
 }
 
 double PricerFXForward::price(Market& mkt, const FixingDataServer* fds) const
 {
+    perf::ScopedLatency latency(perf::lat_pricer_fx_forward);
+
     Date T0 = mkt.today(); // pricing date
     Date T1 = m_fixing_date; // fixing date
     Date T2 = m_settle_date; // settlement date
@@ -5,20 +5,22 @@
 
 namespace minirisk {
 
-struct PricerFXForward : IPricer
+struct PricerFXForward final : IPricer
 {
     PricerFXForward(const TradeFXForward& trd, const std::string& base_ccy);
 
     virtual double price(Market& m, const FixingDataServer* fds = nullptr) const;
 
+    virtual Ccy ccy() const { return m_base_ccy; }
+
 private:
     double m_notional;
-    std::string m_ccy1;
-    std::string m_ccy2;
+    Ccy m_ccy1;
+    Ccy m_ccy2;
     double m_strike;
     Date m_fixing_date;
     Date m_settle_date;
-    std::string m_base_ccy;
+    Ccy m_base_ccy;
     std::string m_fx_pair; // from ccy2 to base ccy, empty if already base
 };
 
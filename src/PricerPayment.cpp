@@ -2,6 +2,7 @@
 #include "TradePayment.h"
 #include "CurveDiscount.h"
 #include "CurveFXSpot.h"
+#include "LatencyHistogram.h"
 
 namespace minirisk {
 
@@ -9,13 +10,15 @@ PricerPayment::PricerPayment(const TradePayment& trd, const std::string& base_cc
     : m_amt(trd.quantity())
     , m_dt(trd.delivery_date())
     , m_ir_curve(ir_curve_discount_name(trd.ccy()))
-    , m_base_ccy(base_ccy)
-    , m_fx_pair(trd.ccy() == base_ccy ? "" : fx_spot_name(trd.ccy(), base_ccy))
+    , m_base_ccy(base_ccy.empty() ? trd.ccy() : Ccy(base_ccy))
+    , m_fx_pair(trd.ccy() == m_base_ccy ? "" : fx_spot_name(trd.ccy(), m_base_ccy))
 {
 }
 
 double PricerPayment::price(Market& mkt, const FixingDataServer* /*fds*/) const
 {
+    perf::ScopedLatency latency(perf::lat_pricer_payment);
+
     Date today = mkt.today();
     
     // Check for expired trade: delivery date must be on or after pricing date
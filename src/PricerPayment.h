@@ -5,17 +5,19 @@
 
 namespace minirisk {
 
-struct PricerPayment : IPricer
+struct PricerPayment final : IPricer
 {
     PricerPayment(const TradePayment& trd, const std::string& base_ccy);
 
     virtual double price(Market& m, const FixingDataServer* fds = nullptr) const;
 
+    virtual Ccy ccy() const { return m_base_ccy; }
+
 private:
     double m_amt;
     Date   m_dt;
     string m_ir_curve;
-    string m_base_ccy;
+    Ccy    m_base_ccy;
     string m_fx_pair; // from trade ccy to base ccy, empty if already base
 };
 
@@ -0,0 +1,100 @@
+#include "Reduction.h"
+#include "Macros.h"
+
+namespace minirisk {
+
+void ReproducibleSum::push_leaf(double s)
+{
+    ++m_leaves;
+    for (unsigned k = 0; k < 64; ++k) {
+        const uint64_t bit = uint64_t(1) << k;
+        if (!(m_occupied & bit)) {
+            m_level[k] = s;
+            m_occupied |= bit;
+            return;
+        }
+        // merge with the earlier subtree of the same size, which is on the left
+        s = m_level[k] + s;
+        m_occupied &= ~bit;
+    }
+}
+
+void ReproducibleSum::end_leaf()
+{
+    push_leaf(leaf_value());
+    m_sum = 0.0;
+    m_comp = 0.0;
+    m_pos = 0;
+}
+
+void ReproducibleSum::add_leaf(double s)
+{
+    MYASSERT(m_pos == 0, "A leaf can only be added at the start of a leaf, position " << size());
+    push_leaf(s);
+}
+
+void ReproducibleSumTree::resize(size_t n)
+{
+    const size_t old_complete = m_size / leaf_size;
+    const size_t complete = n / leaf_size;
+    m_size = n;
+    if (m_nodes.empty())
+        m_nodes.emplace_back();
+    m_nodes[0].resize((n + leaf_size - 1) / leaf_size, 0.0);
+    for (size_t k = 1; (complete >> k) > 0 || k < m_nodes.size(); ++k) {
+        if (k == m_nodes.size())
+            m_nodes.emplace_back();
+        m_nodes[k].resize(complete >> k);
+    }
+    // blocks completed by the new leaves, in order so that each block comes after its halves
+    for (size_t l = old_complete; l < complete; ++l)
+        update_path(l);
+}
+
+void ReproducibleSumTree::set_leaf(size_t l, double s)
+{
+    MYASSERT(l < m_nodes[0].size(), "Leaf " << l << " beyond the " << m_nodes[0].size() << " leaves");
+    m_nodes[0][l] = s;
+    update_path(l);
+}
+
+void ReproducibleSumTree::update_path(size_t l)
+{
+    const size_t complete = m_size / leaf_size;
+    for (size_t k = 1; ((l >> k) + 1) << k <= complete; ++k) {
+        const size_t j = l >> k;
+        m_nodes[k][j] = m_nodes[k - 1][2 * j] + m_nodes[k - 1][2 * j + 1];
+    }
+}
+
+double ReproducibleSumTree::value() const
+{
+    // as ReproducibleSum::value: the incomplete leaf, then the blocks from the latest
+    const size_t complete = m_size / leaf_size;
+    bool any = m_size % leaf_size != 0;
+    double s = any ? m_nodes[0][complete] : 0.0;
+    for (size_t k = 0; (complete >> k) > 0; ++k) {
+        if ((complete >> k) & 1) {
+            const double node = m_nodes[k][(complete >> k) - 1];
+            s = any ? node + s : node;
+            any = true;
+        }
+    }
+    return s;
+}
+
+double ReproducibleSum::value() const
+{
+    // the current leaf is the rightmost, then the subtrees from the latest to the earliest
+    bool any = m_pos > 0;
+    double s = any ? leaf_value() : 0.0;
+    for (unsigned k = 0; k < 64; ++k) {
+        if (m_occupied & (uint64_t(1) << k)) {
+            s = any ? m_level[k] + s : m_level[k];
+            any = true;
+        }
+    }
+    return s;
+}
+
+} // namespace minirisk
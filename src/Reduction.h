@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace minirisk {
+
+// Sum of a sequence of doubles which does not depend on how the sequence is split into blocks
+// or among threads, so that totals are bitwise reproducible. Positions are grouped in leaves
+// of leaf_size consecutive positions, each summed in order with Neumaier compensation, and the
+// leaf sums are combined pairwise along a binary tree whose shape only depends on the number of
+// positions. Positions can be skipped (e.g. trades in error) without moving leaf boundaries.
+struct ReproducibleSum
+{
+    static constexpr size_t leaf_size = 256;
+
+    ReproducibleSum()
+        : m_sum(0.0)
+        , m_comp(0.0)
+        , m_pos(0)
+        , m_leaves(0)
+        , m_occupied(0)
+    {
+    }
+
+    // add the value at the next position
+    void add(double v)
+    {
+        const double t = m_sum + v;
+        m_comp += std::fabs(m_sum) >= std::fabs(v) ? (m_sum - t) + v : (v - t) + m_sum;
+        m_sum = t;
+        if (++m_pos == leaf_size)
+            end_leaf();
+    }
+
+    // move to the next position without adding a value
+    void skip()
+    {
+        if (++m_pos == leaf_size)
+            end_leaf();
+    }
+
+    // move n positions forward without adding values
+    void skip(size_t n)
+    {
+        while (m_pos + n >= leaf_size) {
+            n -= leaf_size - m_pos;
+            end_leaf();
+        }
+        m_pos += n;
+    }
+
+    // Add a whole leaf, starting at the current position, which must be the start of a leaf.
+    // s is the value of a ReproducibleSum of exactly leaf_size positions, e.g. computed on
+    // another thread.
+    void add_leaf(double s);
+
+    // sum of the values added so far
+    double value() const;
+
+    // number of positions so far
+    size_t size() const { return m_leaves * leaf_size + m_pos; }
+
+private:
+    // sum of the current leaf, with its compensation unless it overflowed
+    double leaf_value() const
+    {
+        const double s = m_sum + m_comp;
+        return std::isfinite(s) ? s : m_sum;
+    }
+
+    void end_leaf();
+    void push_leaf(double s);
+
+    double m_sum;           // current leaf
+    double m_comp;
+    size_t m_pos;           // positions in the current leaf
+    size_t m_leaves;        // complete leaves
+
+    // Complete leaves, as a binary counter: m_level[k] holds the sum of 2^k leaves if bit k
+    // of m_occupied is set. Higher levels hold earlier leaves.
+    double m_level[64];
+    uint64_t m_occupied;
+};
+
+// ReproducibleSum of positions whose values change over time. The caller gives the sum of each
+// leaf (a ReproducibleSum of its leaf_size positions), and the tree keeps the sums of the
+// aligned blocks of 2^k complete leaves, which are the subtrees ReproducibleSum combines.
+// Changing a leaf then costs O(log n), and value() is bitwise equal to a ReproducibleSum over
+// all the positions.
+struct ReproducibleSumTree
+{
+    static constexpr size_t leaf_size = ReproducibleSum::leaf_size;
+
+    // number of positions; the leaves added are empty, with sum 0
+    void resize(size_t n);
+
+    size_t size() const { return m_size; }
+
+    // set the sum of leaf l, i.e. of positions [l * leaf_size, (l + 1) * leaf_size)
+    void set_leaf(size_t l, double s);
+
+    // sum of all the positions
+    double value() const;
+
+private:
+    // recompute the blocks containing leaf l
+    void update_path(size_t l);
+
+    size_t m_size = 0;
+
+    // m_nodes[0][l] is the sum of leaf l, and m_nodes[k][j] for k > 0 the sum of the complete
+    // leaves [j 2^k, (j + 1) 2^k)
+    std::vector<std::vector<double>> m_nodes;
+};
+
+} // namespace minirisk
@@ -0,0 +1,101 @@
+#include "ReportWriter.h"
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+namespace minirisk {
+
+// buffers released by the writers of this thread, reused by the next ones
+static thread_local std::vector<std::unique_ptr<char[]>> spare_buffers;
+
+ReportWriter::ReportWriter(std::ostream& os)
+    : m_os(os)
+    , m_pos(0)
+{
+    if (spare_buffers.empty()) {
+        m_buf = new char[buffer_size];
+    } else {
+        m_buf = spare_buffers.back().release();
+        spare_buffers.pop_back();
+    }
+
+    std::ios_base::fmtflags f = os.flags() & std::ios_base::floatfield;
+    m_format = f == std::ios_base::fixed ? std::chars_format::fixed
+        : f == std::ios_base::scientific ? std::chars_format::scientific
+        : std::chars_format::general;
+    m_precision = static_cast<int>(os.precision());
+    if (m_format == std::chars_format::general && m_precision == 0)
+        m_precision = 1; // as %g
+}
+
+ReportWriter::~ReportWriter()
+{
+    flush();
+    spare_buffers.emplace_back(m_buf);
+}
+
+void ReportWriter::flush()
+{
+    if (m_pos) {
+        m_os.write(m_buf, static_cast<std::streamsize>(m_pos));
+        m_pos = 0;
+    }
+}
+
+ReportWriter& ReportWriter::append(const char* s, size_t n)
+{
+    while (n) {
+        if (m_pos == buffer_size)
+            flush();
+        size_t k = std::min(n, buffer_size - m_pos);
+        std::memcpy(m_buf + m_pos, s, k);
+        m_pos += k;
+        s += k;
+        n -= k;
+    }
+    return *this;
+}
+
+ReportWriter& ReportWriter::operator<<(double v)
+{
+    // fixed notation of large numbers can be long: leave room for all the digits
+    const size_t max_size = m_format == std::chars_format::fixed ? 330 + static_cast<size_t>(m_precision) : 32 + static_cast<size_t>(m_precision);
+    char* p = reserve(max_size);
+    m_pos = std::to_chars(p, m_buf + buffer_size, v, m_format, m_precision).ptr - m_buf;
+    return *this;
+}
+
+ReportWriter& ReportWriter::operator<<(const Date& d)
+{
+    unsigned year, month, day;
+    d.serial_to_calendar(year, month, day);
+    char* p = reserve(16);
+    char* end = m_buf + buffer_size;
+    p = std::to_chars(p, end, day).ptr;
+    *p++ = '-';
+    p = std::to_chars(p, end, month).ptr;
+    *p++ = '-';
+    p = std::to_chars(p, end, year).ptr;
+    m_pos = p - m_buf;
+    return *this;
+}
+
+ReportWriter& ReportWriter::label(std::string_view s, size_t width)
+{
+    append(s.data(), s.size());
+    for (size_t i = s.size(); i < width; ++i)
+        *this << ' ';
+    return *this;
+}
+
+ReportWriter& ReportWriter::right(size_t v, size_t width)
+{
+    char digits[24];
+    size_t n = std::to_chars(digits, digits + sizeof(digits), v).ptr - digits;
+    for (size_t i = n; i < width; ++i)
+        *this << ' ';
+    return append(digits, n);
+}
+
+} // namespace minirisk
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+
+#include "Global.h"
+#include "Date.h"
+
+namespace minirisk {
+
+// Text output formatted into a large buffer and written to a stream in big chunks, instead of
+// going through the stream one value at a time. Numbers are formatted with std::to_chars the
+// way the stream would format them with its flags and precision at construction (by default,
+// doubles as %g with 6 significant digits), so the text is the same as with operator<<.
+// Buffers are recycled per thread, so that a writer does not allocate once warmed up.
+// The buffer is written out when full, on flush() and on destruction.
+struct ReportWriter
+{
+    static const size_t buffer_size = 1 << 20;
+
+    explicit ReportWriter(std::ostream& os);
+    ~ReportWriter();
+
+    ReportWriter(const ReportWriter&) = delete;
+    ReportWriter& operator=(const ReportWriter&) = delete;
+
+    ReportWriter& operator<<(char c)
+    {
+        if (m_pos == buffer_size)
+            flush();
+        m_buf[m_pos++] = c;
+        return *this;
+    }
+
+    ReportWriter& operator<<(const char* s) { return append(s, std::strlen(s)); }
+    ReportWriter& operator<<(const string& s) { return append(s.data(), s.size()); }
+
+    ReportWriter& operator<<(double v);
+    ReportWriter& operator<<(int v) { return integer(v); }
+    ReportWriter& operator<<(unsigned v) { return integer(v); }
+    ReportWriter& operator<<(long v) { return integer(v); }
+    ReportWriter& operator<<(unsigned long v) { return integer(v); }
+
+    ReportWriter& operator<<(Ccy c)
+    {
+        if (!c.empty()) {
+            char s[3] = { c[0], c[1], c[2] };
+            append(s, 3);
+        }
+        return *this;
+    }
+
+    // day-month-year, as Date::to_string(true)
+    ReportWriter& operator<<(const Date& d);
+
+    // s left aligned in a field of the given width, as format_label
+    ReportWriter& label(std::string_view s, size_t width = 20);
+
+    // v right aligned in a field of the given width, as with std::setw
+    ReportWriter& right(size_t v, size_t width);
+
+    // write the buffered text to the stream
+    void flush();
+
+private:
+    ReportWriter& append(const char* s, size_t n);
+
+    // make room for n characters (n must not exceed buffer_size)
+    char* reserve(size_t n)
+    {
+        if (buffer_size - m_pos < n)
+            flush();
+        return m_buf + m_pos;
+    }
+
+    template <typename T>
+    ReportWriter& integer(T v)
+    {
+        char* p = reserve(24);
+        m_pos = std::to_chars(p, m_buf + buffer_size, v).ptr - m_buf;
+        return *this;
+    }
+
+    std::ostream& m_os;
+    char* m_buf;
+    size_t m_pos;
+    std::chars_format m_format;
+    int m_precision;
+};
+
+} // namespace minirisk
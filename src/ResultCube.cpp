@@ -0,0 +1,249 @@
+#include "ResultCube.h"
+#include "SensitivityMatrix.h"
+#include "Macros.h"
+#include "ReportWriter.h"
+#include "Reduction.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace minirisk {
+
+namespace {
+
+const char cube_magic[8] = { 'M', 'R', 'C', 'U', 'B', 'E', '0', '1' };
+
+struct cube_header_t
+{
+    char magic[8];
+    uint64_t n_trades;
+    uint64_t n_columns;
+    uint64_t n_messages;
+    uint64_t trades_offset;
+    uint64_t columns_offset;
+    uint64_t names_offset;
+    uint64_t messages_offset;
+};
+
+static_assert(sizeof(cube_header_t) == 64, "Unexpected result cube header size");
+
+inline uint64_t align8(uint64_t n)
+{
+    return (n + 7) & ~uint64_t(7);
+}
+
+inline uint64_t column_size(uint64_t n_trades)
+{
+    return n_trades * sizeof(double) + align8(n_trades * sizeof(uint32_t));
+}
+
+} // namespace
+
+ResultCubeWriter::ResultCubeWriter(const string& filename, size_t n_trades, size_t first_trade)
+    : m_filename(filename)
+    , m_of(filename, std::ios::binary)
+    , m_n_trades(n_trades)
+    , m_pos(0)
+{
+    MYASSERT(!m_of.fail(), "Could not open file " << filename);
+
+    // the header is rewritten by close
+    cube_header_t h;
+    std::memset(&h, 0, sizeof(h));
+    write(&h, sizeof(h));
+
+    std::vector<uint64_t> trades(n_trades);
+    for (size_t i = 0; i < n_trades; ++i)
+        trades[i] = first_trade + i;
+    write(trades.data(), trades.size() * sizeof(uint64_t));
+
+    m_values.reserve(n_trades);
+    m_codes.reserve(n_trades);
+}
+
+void ResultCubeWriter::write(const void* p, size_t n)
+{
+    m_of.write(static_cast<const char*>(p), n);
+    MYASSERT(!m_of.fail(), "Could not write to file " << m_filename);
+    m_pos += n;
+}
+
+void ResultCubeWriter::align()
+{
+    const char zeros[8] = {};
+    write(zeros, align8(m_pos) - m_pos);
+}
+
+void ResultCubeWriter::add(const string& name, const portfolio_values_t& values)
+{
+    MYASSERT(values.size() == m_n_trades, "Column " << name << " has " << values.size() << " trades, expected " << m_n_trades);
+    m_values.clear();
+    m_codes.clear();
+    for (const auto& v : values) {
+        m_values.push_back(v.first);
+        if (!std::isnan(v.first)) {
+            m_codes.push_back(0);
+            continue;
+        }
+        auto ins = m_message_codes.emplace(v.second, static_cast<uint32_t>(m_messages.size() + 1));
+        if (ins.second)
+            m_messages.push_back(v.second);
+        m_codes.push_back(ins.first->second);
+    }
+    add_column(name);
+}
+
+void ResultCubeWriter::add(const string& name, const SensitivityMatrix& m, size_t f)
+{
+    MYASSERT(m.n_trades() == m_n_trades, "Column " << name << " has " << m.n_trades() << " trades, expected " << m_n_trades);
+    m_values.assign(m_n_trades, 0.0);
+    m_codes.assign(m_n_trades, 0);
+    for (size_t k = m.row_begin(f); k < m.row_end(f); ++k) {
+        m_values[m.trade(k)] = m.value(k);
+        if (std::isnan(m.value(k))) {
+            auto ins = m_message_codes.emplace(m.error(k), static_cast<uint32_t>(m_messages.size() + 1));
+            if (ins.second)
+                m_messages.push_back(m.error(k));
+            m_codes[m.trade(k)] = ins.first->second;
+        }
+    }
+    add_column(name);
+}
+
+void ResultCubeWriter::add_column(const string& name)
+{
+    MYASSERT(m_of.is_open(), "Result cube " << m_filename << " is already closed");
+    write(m_values.data(), m_values.size() * sizeof(double));
+    write(m_codes.data(), m_codes.size() * sizeof(uint32_t));
+    align();
+    m_names.push_back(name);
+}
+
+void ResultCubeWriter::close()
+{
+    MYASSERT(m_of.is_open(), "Result cube " << m_filename << " is already closed");
+
+    cube_header_t h;
+    std::memcpy(h.magic, cube_magic, sizeof(h.magic));
+    h.n_trades = m_n_trades;
+    h.n_columns = m_names.size();
+    h.n_messages = m_messages.size();
+    h.trades_offset = sizeof(cube_header_t);
+    h.columns_offset = align8(h.trades_offset + m_n_trades * sizeof(uint64_t));
+
+    // string tables, each string preceded by its length
+    auto write_strings = [this](const std::vector<string>& v) {
+        for (const auto& s : v) {
+            uint32_t n = static_cast<uint32_t>(s.size());
+            write(&n, sizeof(n));
+            write(s.data(), s.size());
+        }
+        align();
+    };
+    h.names_offset = m_pos;
+    write_strings(m_names);
+    h.messages_offset = m_pos;
+    write_strings(m_messages);
+
+    m_of.seekp(0);
+    m_of.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    m_of.close();
+    MYASSERT(!m_of.fail(), "Could not write to file " << m_filename);
+}
+
+ResultCube::ResultCube(const string& filename)
+    : m_file(filename)
+{
+    const char* data = m_file.data();
+    const uint64_t size = m_file.size();
+    MYASSERT(size >= sizeof(cube_header_t), "Invalid result cube file " << filename << ": too short");
+
+    cube_header_t h;
+    std::memcpy(&h, data, sizeof(h));
+    MYASSERT(std::memcmp(h.magic, cube_magic, sizeof(h.magic)) == 0, "Invalid result cube file " << filename << ": bad magic number");
+    MYASSERT(h.trades_offset % 8 == 0 && h.trades_offset <= size
+        && h.n_trades <= size / sizeof(uint64_t) && h.trades_offset + h.n_trades * sizeof(uint64_t) <= size
+        && h.columns_offset % 8 == 0
+        && h.n_columns <= size / std::max<uint64_t>(1, column_size(h.n_trades))
+        && h.columns_offset + h.n_columns * column_size(h.n_trades) <= h.names_offset
+        && h.names_offset <= h.messages_offset && h.messages_offset <= size,
+        "Invalid result cube file " << filename << ": inconsistent header");
+
+    m_n_trades = h.n_trades;
+    m_trades = reinterpret_cast<const uint64_t*>(data + h.trades_offset);
+    m_columns = data + h.columns_offset;
+    m_column_size = column_size(h.n_trades);
+
+    auto read_strings = [&](uint64_t offset, uint64_t end, uint64_t n, std::vector<string>& v) {
+        v.reserve(n);
+        for (uint64_t i = 0; i < n; ++i) {
+            uint32_t len;
+            MYASSERT(offset + sizeof(len) <= end, "Invalid result cube file " << filename << ": truncated string table");
+            std::memcpy(&len, data + offset, sizeof(len));
+            offset += sizeof(len);
+            MYASSERT(offset + len <= end, "Invalid result cube file " << filename << ": truncated string table");
+            v.emplace_back(data + offset, len);
+            offset += len;
+        }
+    };
+    read_strings(h.names_offset, h.messages_offset, h.n_columns, m_names);
+    read_strings(h.messages_offset, size, h.n_messages, m_messages);
+}
+
+portfolio_values_t ResultCube::column(size_t c) const
+{
+    const double* v = values(c);
+    const uint32_t* e = codes(c);
+    portfolio_values_t res(m_n_trades);
+    for (size_t i = 0; i < m_n_trades; ++i) {
+        res[i].first = v[i];
+        if (e[i])
+            res[i].second = message(e[i]);
+    }
+    return res;
+}
+
+void print_result_column(const ResultCube& cube, size_t c, std::ostream& os)
+{
+    const double* v = cube.values(c);
+    const uint32_t* e = cube.codes(c);
+
+    // total as computed by portfolio_total
+    ReproducibleSum total;
+    size_t errors = 0;
+    for (size_t i = 0; i < cube.n_trades(); ++i) {
+        if (e[i]) {
+            total.skip();
+            ++errors;
+        } else {
+            total.add(v[i]);
+        }
+    }
+
+    ReportWriter w(os);
+    w
+        << "========================\n"
+        << cube.name(c) << ":\n"
+        << "========================\n"
+        << "Total:  " << total.value() << "\n";
+
+    if (errors > 0) {
+        w << "Errors: " << errors << "\n";
+    }
+
+    w << "\n========================\n";
+
+    for (size_t i = 0; i < cube.n_trades(); ++i) {
+        w.right(cube.trade(i), 5) << ": ";
+        if (e[i])
+            w << cube.message(e[i]);
+        else
+            w << v[i];
+        w << '\n';
+    }
+
+    w << "========================\n\n";
+}
+
+} // namespace minirisk
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <fstream>
+#include <unordered_map>
+
+#include "PortfolioUtils.h"
+#include "MappedFile.h"
+#include "Macros.h"
+
+namespace minirisk {
+
+struct SensitivityMatrix;
+
+// Binary columnar file of results: one column per measure (PV, each sensitivity), with a
+// value and an error code per trade. Code 0 means no error, code k the k-th error message.
+//
+// Layout (native byte order, all sections 8 byte aligned):
+//   header       magic "MRCUBE01", n_trades, n_columns, n_messages, offsets of the sections
+//   trade ids    uint64 per trade: position of the trade in the portfolio
+//   columns      per column: double values[n_trades], then uint32 codes[n_trades]
+//   names        per column: uint32 length and characters
+//   messages     per message: uint32 length and characters
+//
+// Columns are written as they are computed, each with a single write; the header is written
+// last. The file is read through a memory map, without parsing the values.
+struct ResultCubeWriter
+{
+    // rows are the trades first_trade, first_trade + 1, ... of the portfolio
+    ResultCubeWriter(const string& filename, size_t n_trades, size_t first_trade = 0);
+
+    ResultCubeWriter(const ResultCubeWriter&) = delete;
+    ResultCubeWriter& operator=(const ResultCubeWriter&) = delete;
+
+    void add(const string& name, const portfolio_values_t& values);
+    void add(const string& name, const SensitivityMatrix& m, size_t f);
+
+    // write the names, messages and header; must be called once all columns have been added
+    void close();
+
+private:
+    void write(const void* p, size_t n);
+    void align();
+    void add_column(const string& name);
+
+    string m_filename;
+    std::ofstream m_of;
+    uint64_t m_n_trades;
+    uint64_t m_pos;
+    std::vector<string> m_names;
+    std::vector<string> m_messages;
+    std::unordered_map<string, uint32_t> m_message_codes;
+    std::vector<double> m_values;   // column being written
+    std::vector<uint32_t> m_codes;
+};
+
+struct ResultCube
+{
+    explicit ResultCube(const string& filename);
+
+    size_t n_trades() const { return m_n_trades; }
+    size_t n_columns() const { return m_names.size(); }
+
+    const string& name(size_t c) const { return m_names[c]; }
+    uint64_t trade(size_t i) const { return m_trades[i]; }
+
+    // n_trades() values and error codes of column c, in the mapped file
+    const double* values(size_t c) const { return reinterpret_cast<const double*>(m_columns + c * m_column_size); }
+    const uint32_t* codes(size_t c) const { return reinterpret_cast<const uint32_t*>(m_columns + c * m_column_size + m_n_trades * sizeof(double)); }
+
+    // message of a non zero error code (codes are read from the file, so they are checked)
+    const string& message(uint32_t code) const
+    {
+        MYASSERT(code > 0 && code <= m_messages.size(), "Invalid result cube: error code " << code << " beyond the " << m_messages.size() << " messages");
+        return m_messages[code - 1];
+    }
+
+    // column c in the format of the compute_* functions
+    portfolio_values_t column(size_t c) const;
+
+private:
+    MappedFile m_file;
+    size_t m_n_trades;
+    const uint64_t* m_trades;
+    const char* m_columns;
+    size_t m_column_size;
+    std::vector<string> m_names;
+    std::vector<string> m_messages;
+};
+
+// Print column c in the format of print_price_vector
+void print_result_column(const ResultCube& cube, size_t c, std::ostream& os = std::cout);
+
+} // namespace minirisk
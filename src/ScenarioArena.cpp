@@ -0,0 +1,75 @@
+#include "ScenarioArena.h"
+#include "Macros.h"
+
+#include <cstdint>
+#include <new>
+
+namespace minirisk {
+
+ScenarioArena::ScenarioArena(size_t initial_chunk_size)
+    : m_current(0)
+    , m_offset(0)
+    , m_next_size(initial_chunk_size)
+    , m_capacity(0)
+    , m_live(0)
+    , m_allocations(0)
+    , m_resets(0)
+{
+    MYASSERT(initial_chunk_size > 0, "Arena chunk size cannot be zero");
+}
+
+ScenarioArena::~ScenarioArena()
+{
+    for (auto& c : m_chunks)
+        ::operator delete(c.data);
+}
+
+bool ScenarioArena::reset()
+{
+    if (m_live)
+        return false;
+    if (m_current || m_offset)
+        ++m_resets;
+    m_current = 0;
+    m_offset = 0;
+    return true;
+}
+
+void* ScenarioArena::do_allocate(size_t bytes, size_t alignment)
+{
+    ++m_allocations;
+    ++m_live;
+
+    // bump allocation in the current chunk, else move on to the next one which fits
+    for (; m_current < m_chunks.size(); ++m_current, m_offset = 0) {
+        const chunk_t& c = m_chunks[m_current];
+        uintptr_t base = reinterpret_cast<uintptr_t>(c.data);
+        size_t start = ((base + m_offset + alignment - 1) & ~(uintptr_t(alignment) - 1)) - base;
+        if (start + bytes <= c.size) {
+            m_offset = start + bytes;
+            return c.data + start;
+        }
+    }
+
+    // no chunk left: get a new one from the heap, twice as big as the previous one
+    size_t size = std::max(m_next_size, bytes + alignment);
+    m_next_size = 2 * size;
+    std::byte* data = static_cast<std::byte*>(::operator new(size));
+    m_chunks.push_back(chunk_t{ data, size });
+    m_capacity += size;
+    m_current = m_chunks.size() - 1;
+
+    uintptr_t base = reinterpret_cast<uintptr_t>(data);
+    size_t start = ((base + alignment - 1) & ~(uintptr_t(alignment) - 1)) - base;
+    m_offset = start + bytes;
+    return data + start;
+}
+
+void ScenarioArena::do_deallocate(void* /*p*/, size_t /*bytes*/, size_t /*alignment*/)
+{
+    // memory is only reclaimed by reset
+    if (m_live)
+        --m_live;
+}
+
+} // namespace minirisk
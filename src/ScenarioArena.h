@@ -0,0 +1,83 @@
+#pragma once
+
+#include <memory_resource>
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+namespace minirisk {
+
+// Monotonic memory resource for the objects built while pricing one scenario (curves, their
+// control blocks and vectors). Allocation bumps a pointer into the current chunk and
+// deallocation only counts the live blocks; once all of them are released, reset() rewinds to
+// the first chunk, so that the next scenario reuses the same memory without calling the heap.
+// Not thread safe: each arena belongs to a single Market.
+struct ScenarioArena : std::pmr::memory_resource
+{
+    explicit ScenarioArena(size_t initial_chunk_size = 64 * 1024);
+    ~ScenarioArena();
+
+    ScenarioArena(const ScenarioArena&) = delete;
+    ScenarioArena& operator=(const ScenarioArena&) = delete;
+
+    // rewind to the beginning if no block is in use; returns false (and does nothing) otherwise
+    bool reset();
+
+    size_t live_blocks() const { return m_live; }
+    size_t allocations() const { return m_allocations; }
+    size_t resets() const { return m_resets; }
+
+    // total size of the chunks obtained from the heap
+    size_t capacity() const { return m_capacity; }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    struct chunk_t
+    {
+        std::byte* data;
+        size_t size;
+    };
+
+    std::vector<chunk_t> m_chunks;
+    size_t m_current;         // chunk being filled
+    size_t m_offset;          // first free byte in the current chunk
+    size_t m_next_size;       // size of the next chunk to obtain from the heap
+    size_t m_capacity;
+    size_t m_live;
+    size_t m_allocations;
+    size_t m_resets;
+};
+
+typedef std::shared_ptr<ScenarioArena> parena_t;
+
+// Allocator sharing the ownership of an arena, so that the arena outlives the blocks
+// allocated with it (e.g. a shared_ptr control block released after its Market is gone).
+template <typename T>
+struct arena_allocator
+{
+    typedef T value_type;
+
+    explicit arena_allocator(const parena_t& arena) : m_arena(arena) {}
+    template <typename U>
+    arena_allocator(const arena_allocator<U>& a) : m_arena(a.m_arena) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T* p, size_t n) { m_arena->deallocate(p, n * sizeof(T), alignof(T)); }
+
+    template <typename U>
+    bool operator==(const arena_allocator<U>& a) const { return m_arena == a.m_arena; }
+
+    parena_t m_arena;
+};
+
+// Create a T in the arena, with its shared_ptr control block in the arena as well.
+template <typename T, typename... Args>
+std::shared_ptr<T> make_shared_in_arena(const parena_t& arena, Args&&... args)
+{
+    return std::allocate_shared<T>(arena_allocator<T>(arena), std::forward<Args>(args)...);
+}
+
+} // namespace minirisk
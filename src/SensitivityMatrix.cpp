@@ -0,0 +1,107 @@
+#include "SensitivityMatrix.h"
+#include "Macros.h"
+#include "ReportWriter.h"
+#include "Reduction.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace minirisk {
+
+void SensitivityMatrix::add_factor(const string& name, const portfolio_values_t& values)
+{
+    if (m_factors.empty())
+        m_n_trades = values.size();
+    MYASSERT(values.size() == m_n_trades, "Risk factor " << name << " has " << values.size() << " trades, expected " << m_n_trades);
+    MYASSERT(m_n_trades <= std::numeric_limits<uint32_t>::max(), "Too many trades for a sensitivity matrix: " << m_n_trades);
+
+    ReproducibleSum total;
+    size_t errors = 0;
+    for (size_t i = 0; i < values.size(); ++i) {
+        double v = values[i].first;
+        if (std::isnan(v)) {
+            auto ins = m_message_ids.emplace(values[i].second, static_cast<uint32_t>(m_messages.size()));
+            if (ins.second)
+                m_messages.push_back(values[i].second);
+            m_entry_errors.emplace_back(m_trade.size(), ins.first->second);
+            total.skip();
+            ++errors;
+        } else if (v == 0.0 && !std::signbit(v)) {
+            total.add(v); // not stored, but added as portfolio_total does (-0 + 0 is 0)
+            continue;
+        } else {
+            total.add(v);
+        }
+        m_trade.push_back(static_cast<uint32_t>(i));
+        m_value.push_back(v);
+    }
+
+    m_factors.push_back(name);
+    m_row.push_back(m_trade.size());
+    m_total.push_back(total.value());
+    m_errors.push_back(errors);
+}
+
+void SensitivityMatrix::reserve(size_t n_factors)
+{
+    m_factors.reserve(n_factors);
+    m_row.reserve(n_factors + 1);
+    m_total.reserve(n_factors);
+    m_errors.reserve(n_factors);
+}
+
+const string& SensitivityMatrix::error(size_t k) const
+{
+    auto it = std::lower_bound(m_entry_errors.begin(), m_entry_errors.end(), std::make_pair(k, uint32_t(0)));
+    MYASSERT(it != m_entry_errors.end() && it->first == k, "Sensitivity entry " << k << " is not an error");
+    return m_messages[it->second];
+}
+
+portfolio_values_t SensitivityMatrix::dense(size_t f) const
+{
+    portfolio_values_t res(m_n_trades, std::make_pair(0.0, string()));
+    for (size_t k = row_begin(f); k < row_end(f); ++k)
+        res[m_trade[k]] = std::isnan(m_value[k])
+            ? std::make_pair(m_value[k], error(k))
+            : std::make_pair(m_value[k], string());
+    return res;
+}
+
+void print_sensitivity(const string& name, const SensitivityMatrix& m, size_t f, bool sparse, std::ostream& os)
+{
+    ReportWriter w(os);
+    w
+        << "========================\n"
+        << name << ":\n"
+        << "========================\n"
+        << "Total:  " << m.total(f) << "\n";
+
+    if (m.errors(f) > 0) {
+        w << "Errors: " << m.errors(f) << "\n";
+    }
+
+    w << "\n========================\n";
+
+    // walk the trades, taking the stored entries in turn (the others are zero)
+    size_t k = m.row_begin(f), end = m.row_end(f);
+    for (size_t i = 0, n = m.n_trades(); i < n; ++i) {
+        bool stored = k < end && m.trade(k) == i;
+        if (!stored && sparse)
+            continue;
+        w.right(i, 5) << ": ";
+        if (!stored)
+            w << 0.0;
+        else if (std::isnan(m.value(k)))
+            w << m.error(k);
+        else
+            w << m.value(k);
+        w << '\n';
+        if (stored)
+            ++k;
+    }
+
+    w << "========================\n\n";
+}
+
+} // namespace minirisk
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <iostream>
+
+#include "PortfolioUtils.h"
+
+namespace minirisk {
+
+// Sensitivities of the trades of a portfolio to a list of risk factors, stored in compressed
+// sparse rows (one row per risk factor): only structurally non zero entries are kept, i.e.
+// non zero values and errors. A trade has a zero sensitivity to the risk factors it does not
+// depend on (e.g. a EUR payment to the GBP curve), so the size of the matrix grows with the
+// number of dependencies rather than with trades x risk factors.
+// Error messages are stored once and shared by all the entries in error with the same message.
+struct SensitivityMatrix
+{
+    SensitivityMatrix() : m_n_trades(0), m_row(1, 0) {}
+
+    // append a risk factor with the sensitivities of all trades (as computed by the compute_*
+    // functions); all risk factors must have the same number of trades
+    void add_factor(const string& name, const portfolio_values_t& values);
+
+    void reserve(size_t n_factors);
+
+    size_t n_trades() const { return m_n_trades; }
+    size_t n_factors() const { return m_factors.size(); }
+
+    // number of stored entries
+    size_t nnz() const { return m_trade.size(); }
+
+    const string& factor(size_t f) const { return m_factors[f]; }
+
+    // the stored entries of risk factor f are those in [row_begin(f), row_end(f)), by trade
+    size_t row_begin(size_t f) const { return m_row[f]; }
+    size_t row_end(size_t f) const { return m_row[f + 1]; }
+
+    size_t trade(size_t k) const { return m_trade[k]; }
+    double value(size_t k) const { return m_value[k]; } // NaN if the entry is in error
+    const string& error(size_t k) const;               // message of an entry in error
+
+    // sum of the values and number of errors of risk factor f, as computed by portfolio_total
+    double total(size_t f) const { return m_total[f]; }
+    size_t errors(size_t f) const { return m_errors[f]; }
+
+    // all the values of risk factor f, in the format of the compute_* functions
+    portfolio_values_t dense(size_t f) const;
+
+private:
+    size_t m_n_trades;
+    std::vector<string> m_factors;
+    std::vector<size_t> m_row;      // n_factors() + 1 offsets into the entries
+    std::vector<uint32_t> m_trade;  // entries: trade index
+    std::vector<double> m_value;    // entries: value
+    std::vector<std::pair<size_t, uint32_t>> m_entry_errors;  // (entry, message) by entry
+    std::vector<string> m_messages;
+    std::unordered_map<string, uint32_t> m_message_ids;
+    std::vector<double> m_total;
+    std::vector<size_t> m_errors;
+};
+
+// Print the sensitivities to risk factor f in the format of print_price_vector. If sparse,
+// only the stored entries are listed.
+void print_sensitivity(const string& name, const SensitivityMatrix& m, size_t f, bool sparse = false, std::ostream& os = std::cout);
+
+} // namespace minirisk
@@ -0,0 +1,166 @@
+#include "ShardedRisk.h"
+#include "ResultCube.h"
+#include "SensitivityMatrix.h"
+#include "MarketSnapshot.h"
+#include "MarketDataServer.h"
+#include "FixingDataServer.h"
+#include "TaskScheduler.h"
+#include "Market.h"
+#include "Macros.h"
+
+#include <iostream>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace minirisk {
+
+namespace {
+
+// first trade of shard k of n_shards (the last bound is the number of trades)
+size_t shard_begin(size_t n_trades, size_t k, size_t n_shards)
+{
+    return n_trades * k / n_shards;
+}
+
+// Body of worker process k: price its shard against the snapshot and write the results to
+// cube_file. Never returns.
+[[noreturn]] void run_worker(unsigned k, const string& snapshot_name, const std::vector<ppricer_t>& pricers, size_t begin, size_t end, const FixingDataServer* fds, unsigned n_threads, const string& cube_file)
+{
+    int status = 0;
+    try {
+        TaskScheduler::set_global_threads_after_fork(n_threads);
+
+        std::shared_ptr<const MarketDataServer> mds(new MarketDataServer(std::make_shared<const MarketSnapshot>(snapshot_name)));
+        Date today(2017,8,5);
+        Market mkt(mds, today);
+        for (const auto& rf : mds->match(".+"))
+            mkt.get_value(rf, "risk factor");
+
+        const std::vector<ppricer_t> shard(pricers.begin() + begin, pricers.begin() + end);
+        ResultCubeWriter cube(cube_file, shard.size(), begin);
+        cube.add("PV", compute_prices(shard, mkt, fds));
+
+        auto add = [&cube](const string& prefix, const std::vector<SensitivityMatrix>& res) {
+            const SensitivityMatrix& m = res.front();
+            for (size_t f = 0; f < m.n_factors(); ++f)
+                cube.add(prefix + m.factor(f), m, f);
+        };
+        add("PV01 bucketed ", compute_pv01_bucketed_sparse(shard, mkt, fds));
+        add("PV01 parallel ", compute_pv01_parallel_sparse(shard, mkt, fds));
+        add("FX delta ", compute_fx_delta_sparse(shard, mkt, fds));
+        cube.close();
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Worker " << k << ": " << e.what() << std::endl;
+        status = 1;
+    }
+    catch (...) {
+        std::cerr << "Worker " << k << ": unknown exception" << std::endl;
+        status = 1;
+    }
+    // skip the destructors of the objects inherited from the parent
+    std::cout.flush();
+    ::_exit(status);
+}
+
+} // namespace
+
+sharded_result_t run_sharded(const string& portfolio_file, const string& risk_factors_file, const string& base_ccy, const string& fixings_file, unsigned n_workers, unsigned threads_per_worker)
+{
+    MYASSERT(n_workers > 0, "The number of workers must be positive");
+
+    // everything the workers share is built before the fork, and inherited copy on write
+    portfolio_t portfolio = load_portfolio(portfolio_file);
+    const std::vector<ppricer_t> pricers = get_pricers(portfolio, base_ccy);
+    std::unique_ptr<FixingDataServer> fds;
+    if (!fixings_file.empty())
+        fds.reset(new FixingDataServer(fixings_file));
+
+    const string tag = "minirisk." + std::to_string(::getpid());
+    std::unique_ptr<MarketSnapshot> snapshot;
+    {
+        MarketDataServer mds(risk_factors_file);
+        snapshot.reset(new MarketSnapshot("/" + tag, mds));
+    }
+
+    sharded_result_t res;
+    res.trades = pricers.size();
+    res.workers = std::max<size_t>(1, std::min<size_t>(n_workers, pricers.size()));
+
+    const std::filesystem::path dir = std::filesystem::temp_directory_path();
+    std::vector<string> cube_files;
+    for (size_t k = 0; k < res.workers; ++k)
+        cube_files.push_back((dir / (tag + ".shard" + std::to_string(k) + ".bin")).string());
+
+    // buffered output would otherwise be written by the parent and by every worker
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+
+    std::vector<pid_t> pids;
+    string error;
+    for (size_t k = 0; k < res.workers; ++k) {
+        pid_t pid = ::fork();
+        if (pid == 0)
+            run_worker(static_cast<unsigned>(k), snapshot->name(), pricers,
+                shard_begin(res.trades, k, res.workers), shard_begin(res.trades, k + 1, res.workers),
+                fds.get(), threads_per_worker, cube_files[k]);
+        if (pid < 0) {
+            error = "Could not start worker " + std::to_string(k) + ": " + std::strerror(errno);
+            break;
+        }
+        pids.push_back(pid);
+    }
+
+    // wait for all the workers, even after a failure, so that none is left behind
+    for (size_t k = 0; k < pids.size(); ++k) {
+        int status = 0;
+        pid_t pid;
+        do {
+            pid = ::waitpid(pids[k], &status, 0);
+        } while (pid < 0 && errno == EINTR);
+        if (error.empty() && (pid < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0))
+            error = "Worker " + std::to_string(k) + " failed";
+    }
+
+    // merge the columns of the shards in trade order
+    try {
+        MYASSERT(error.empty(), error);
+        for (size_t k = 0; k < res.workers; ++k) {
+            ResultCube cube(cube_files[k]);
+            const size_t begin = shard_begin(res.trades, k, res.workers);
+            MYASSERT(cube.n_trades() == shard_begin(res.trades, k + 1, res.workers) - begin
+                    && (cube.n_trades() == 0 || cube.trade(0) == begin),
+                "Worker " << k << " results do not cover its shard");
+            if (k == 0) {
+                for (size_t c = 0; c < cube.n_columns(); ++c) {
+                    res.measures.emplace_back(cube.name(c), portfolio_values_t());
+                    res.measures.back().second.reserve(res.trades);
+                }
+            }
+            MYASSERT(cube.n_columns() == res.measures.size(), "Worker " << k << " results have " << cube.n_columns() << " columns, expected " << res.measures.size());
+            for (size_t c = 0; c < cube.n_columns(); ++c) {
+                MYASSERT(cube.name(c) == res.measures[c].first, "Worker " << k << " column " << c << " is " << cube.name(c) << ", expected " << res.measures[c].first);
+                portfolio_values_t values = cube.column(c);
+                auto& out = res.measures[c].second;
+                out.insert(out.end(), std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()));
+            }
+        }
+    }
+    catch (...) {
+        for (const auto& fn : cube_files)
+            std::remove(fn.c_str());
+        throw;
+    }
+    for (const auto& fn : cube_files)
+        std::remove(fn.c_str());
+
+    return res;
+}
+
+} // namespace minirisk
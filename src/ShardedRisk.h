@@ -0,0 +1,30 @@
+#pragma once
+
+#include "PortfolioUtils.h"
+
+namespace minirisk {
+
+// Results of a sharded risk run: one column per measure, with the values of all the trades
+// in portfolio order
+struct sharded_result_t
+{
+    std::vector<std::pair<string, portfolio_values_t>> measures;
+
+    size_t trades;
+    size_t workers;
+};
+
+// Compute PV, PV01 bucketed, PV01 parallel and FX delta of a portfolio in base_ccy on
+// n_workers processes, each with threads_per_worker threads (0 for the hardware concurrency).
+//
+// The parent loads the portfolio, binds the pricers and publishes the risk factors in a read
+// only shared memory snapshot (see MarketSnapshot.h), then forks the workers. Worker k prices
+// the k-th contiguous shard of the trades against the snapshot, with all risk factors cached
+// so that every shard is bumped on the same set, and writes its results to a ResultCube file.
+// The parent merges the cubes in shard order: the results do not depend on n_workers.
+//
+// Threads of the parent are not inherited by the workers: this must be called before any
+// other thread than the caller's is running, except those of the global TaskScheduler.
+sharded_result_t run_sharded(const string& portfolio_file, const string& risk_factors_file, const string& base_ccy, const string& fixings_file, unsigned n_workers, unsigned threads_per_worker = 1);
+
+} // namespace minirisk
@@ -36,6 +36,7 @@ struct my_ofstream
     }
 
     void endl() { m_of << std::endl; }
+    void newline() { m_of << '\n'; } // end the line without flushing
     void close() { m_of.close(); }
     std::ofstream m_of;
 };
@@ -48,6 +49,9 @@ struct my_ifstream
         MYASSERT(!m_if.fail(), "Could not open file " << fn);
     }
 
+    // not associated to any file: lines are provided with set_line
+    my_ifstream() {}
+
     template <typename T>
     friend my_ifstream& operator>>(my_ifstream& is, T& v)
     {
@@ -57,10 +61,22 @@ struct my_ifstream
     }
 
 
+    // read the next line, false at the end of the file or on an empty line
     bool read_line()
     {
-        std::getline(m_if, m_line);  // read a line and store it in m_line
-        m_line_stream.str(m_line);   // associate a string stream with m_line
+        if (!std::getline(m_if, m_line))  // read a line and store it in m_line
+            return false;
+        m_line_stream.clear();             // forget the end of the previous line
+        m_line_stream.str(m_line);         // associate a string stream with m_line
+        return m_line.length() > 0;
+    }
+
+    // parse tokens from a line held in memory instead of reading it from the file
+    bool set_line(const string& line)
+    {
+        m_line = line;
+        m_line_stream.clear();
+        m_line_stream.str(m_line);
         return m_line.length() > 0;
     }
 
@@ -128,21 +144,43 @@ inline my_ofstream& operator<<(my_ofstream& os, const Date& d)
     return os;
 }
 
+// first word of a token, as read by operator>> into a string
+inline string first_word(string tmp)
+{
+    const char* blanks = " \t\n\v\f\r";
+    size_t begin = std::min(tmp.find_first_not_of(blanks), tmp.length());
+    size_t end = std::min(tmp.find_first_of(blanks, begin), tmp.length());
+    return tmp.erase(end).erase(0, begin);
+}
+
+//
+// Ccy streamer overloads
+//
+
+inline my_ifstream& operator>>(my_ifstream& is, Ccy& v)
+{
+    v = Ccy(first_word(is.read_token()));
+    return is;
+}
+
 inline my_ifstream& operator>>(my_ifstream& is, Date& v)
 {
-    string tmp;
-    is >> tmp;
-    
+    string tmp = first_word(is.read_token());
+
     // Check if it's a serial date (5 digits or less) or a YYYYMMDD format (8 digits)
+    unsigned y, m, d;
     if (tmp.length() <= 5) {
         // Handle serial date format - use the Date(unsigned serial) constructor
         unsigned serial = std::atoi(tmp.c_str());
         v = Date(serial);
-    } else {
+    } else if (tmp.length() >= Date::YYYYMMDD_SIZE && Date::parse_yyyymmdd(tmp.data(), y, m, d)) {
         // Handle YYYYMMDD format
-        unsigned y = std::atoi(tmp.substr(0, 4).c_str());
-        unsigned m = std::atoi(tmp.substr(4, 2).c_str());
-        unsigned d = std::atoi(tmp.substr(6, 2).c_str());
+        v.init(y, m, d);
+    } else {
+        // Not all digits: fields read with atoi, as they always were
+        y = std::atoi(tmp.substr(0, 4).c_str());
+        m = std::atoi(tmp.substr(4, 2).c_str());
+        d = std::atoi(tmp.substr(6, 2).c_str());
         v.init(y, m, d);
     }
     return is;
@@ -0,0 +1,113 @@
+#include "StreamingRisk.h"
+#include "Macros.h"
+#include "Trace.h"
+#include "Reduction.h"
+
+#include <set>
+#include <cmath>
+
+namespace minirisk {
+
+size_t streaming_block_size(size_t memory_limit, size_t n_measures)
+{
+    // Rough footprint of a trade: the trade, its pricer and their shared_ptr control blocks,
+    // one result per measure, and the down/up scenario buffers. Error messages are assumed
+    // to fit in the small string buffer.
+    const size_t trade_bytes = 512;
+    const size_t bytes_per_trade = trade_bytes + (n_measures + 2) * sizeof(std::pair<double, string>);
+    return std::max<size_t>(1, memory_limit / bytes_per_trade);
+}
+
+// number of results per trade: PV, then PV01 per tenor and per currency, and FX delta per spot
+static size_t count_measures(const Market& mkt)
+{
+    auto ir = mkt.get_risk_factors("IR\\.[0-9]+[DWMY]\\.[A-Z]{3}$");
+    std::set<string> ccys;
+    for (const auto& rf : ir)
+        ccys.insert(rf.first.substr(rf.first.length() - 3, 3));
+    return 1 + ir.size() + ccys.size() + mkt.get_risk_factors("FX\\.SPOT\\.[A-Z]{3}$").size();
+}
+
+streaming_result_t stream_risk(const string& portfolio_file, const string& base_ccy, Market& mkt, const FixingDataServer* fds
+    , size_t memory_limit, const string& output_file)
+{
+    MYASSERT(memory_limit > 0, "Memory limit cannot be zero");
+
+    streaming_result_t res;
+    res.trades = 0;
+    res.blocks = 0;
+    res.block_size = streaming_block_size(memory_limit, count_measures(mkt));
+
+    PortfolioReader reader(portfolio_file);
+    my_ofstream of(output_file);
+    MYASSERT(!of.m_of.fail(), "Could not open file " << output_file);
+
+    portfolio_t block;
+    block.reserve(res.block_size);
+    std::vector<std::pair<string, portfolio_values_t>> measures;
+    std::vector<ReproducibleSum> sums;    // totals of the measures, whatever the block size
+    while (reader.read(res.block_size, block)) {
+        trace::ScopedEvent event("block", "streaming");
+        const size_t first = reader.position() - block.size();
+
+        // price the block in every scenario
+        {
+            std::vector<ppricer_t> pricers(get_pricers(block, base_ccy));
+            measures.emplace_back("PV", compute_prices(pricers, mkt, fds));
+            for (auto& g : compute_pv01_bucketed(pricers, mkt, fds))
+                measures.emplace_back("PV01 bucketed " + g.first, std::move(g.second));
+            for (auto& g : compute_pv01_parallel(pricers, mkt, fds))
+                measures.emplace_back("PV01 parallel " + g.first, std::move(g.second));
+            for (auto& g : compute_fx_delta(pricers, mkt, fds))
+                measures.emplace_back("FX delta " + g.first, std::move(g.second));
+        }
+        block.clear();
+
+        // the first block determines the columns
+        if (res.blocks == 0) {
+            of << "trade";
+            for (const auto& m : measures) {
+                of << m.first;
+                res.totals.emplace_back(m.first, 0.0, 0);
+            }
+            sums.resize(measures.size());
+            of.newline();
+        }
+        MYASSERT(measures.size() == res.totals.size(),
+            "Risk factors of block " << res.blocks << " differ from the first block: all risk factors must be cached in the market");
+        for (size_t k = 0; k < measures.size(); ++k)
+            MYASSERT(measures[k].first == std::get<0>(res.totals[k]),
+                "Risk factors of block " << res.blocks << " differ from the first block: all risk factors must be cached in the market");
+
+        // append the results and update the totals in trade order
+        const size_t n = measures.front().second.size();
+        for (size_t i = 0; i < n; ++i) {
+            of << first + i;
+            for (size_t k = 0; k < measures.size(); ++k) {
+                const auto& v = measures[k].second[i];
+                if (std::isnan(v.first)) {
+                    of << v.second;
+                    sums[k].skip();
+                    ++std::get<2>(res.totals[k]);
+                } else {
+                    of << v.first;
+                    sums[k].add(v.first);
+                }
+            }
+            of.newline();
+        }
+        of.m_of.flush();
+        MYASSERT(!of.m_of.fail(), "Could not write to file " << output_file);
+        measures.clear();
+
+        res.trades += n;
+        ++res.blocks;
+    }
+    of.close();
+
+    for (size_t k = 0; k < sums.size(); ++k)
+        std::get<1>(res.totals[k]) = sums[k].value();
+    return res;
+}
+
+} // namespace minirisk
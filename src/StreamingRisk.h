@@ -0,0 +1,36 @@
+#pragma once
+
+#include <tuple>
+
+#include "PortfolioUtils.h"
+#include "Market.h"
+
+namespace minirisk {
+
+// Totals of a streaming risk run
+struct streaming_result_t
+{
+    // (measure, total, number of trades in error), in the order of the output columns
+    typedef std::tuple<string, double, size_t> total_t;
+    std::vector<total_t> totals;
+
+    size_t trades;
+    size_t blocks;
+    size_t block_size;
+};
+
+// Number of trades per block so that a block, its pricers and all its results fit in
+// memory_limit bytes, for n_measures results per trade (at least one trade)
+size_t streaming_block_size(size_t memory_limit, size_t n_measures);
+
+// Compute PV, PV01 bucketed, PV01 parallel and FX delta of a portfolio too large to be held in
+// memory. The portfolio is read in blocks sized after memory_limit, and each block is priced
+// with the base and all bumped scenarios. Per trade results are appended to output_file (one
+// line per trade, one column per measure, the error message in place of a failed value) and
+// only the totals are kept. Totals are reproducible sums by trade position (see Reduction.h),
+// so they are the same as those of the in-memory functions, whatever the block size.
+// All risk factors must be cached in mkt beforehand, so that every block is bumped the same way.
+streaming_result_t stream_risk(const string& portfolio_file, const string& base_ccy, Market& mkt, const FixingDataServer* fds
+    , size_t memory_limit, const string& output_file);
+
+} // namespace minirisk
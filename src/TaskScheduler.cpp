@@ -0,0 +1,223 @@
+#include "TaskScheduler.h"
+#include "PerfCounters.h"
+
+#include <algorithm>
+
+namespace minirisk {
+
+static thread_local bool t_in_task = false;
+
+TaskScheduler::TaskScheduler(unsigned n_threads)
+    : m_n_threads(n_threads ? n_threads : std::max(1u, std::thread::hardware_concurrency()))
+    , m_generation(0)
+    , m_active(0)
+    , m_stop(false)
+    , m_body(nullptr)
+    , m_grain(1)
+    , m_remaining(0)
+    , m_error_begin(0)
+{
+    for (unsigned w = 0; w < m_n_threads; ++w)
+        m_workers.emplace_back(new worker_t);
+    for (unsigned w = 1; w < m_n_threads; ++w)
+        m_threads.emplace_back(&TaskScheduler::thread_main, this, w);
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+    for (auto& t : m_threads)
+        t.join();
+}
+
+bool TaskScheduler::in_task()
+{
+    return t_in_task;
+}
+
+void TaskScheduler::thread_main(unsigned w)
+{
+    t_in_task = true;
+    unsigned generation = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [&] { return m_stop || m_generation != generation; });
+            if (m_stop)
+                return;
+            generation = m_generation;
+        }
+        run_worker(w);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_active == 0)
+                m_done.notify_all();
+        }
+    }
+}
+
+void TaskScheduler::push(unsigned w, const range_t& r)
+{
+    std::lock_guard<std::mutex> lock(m_workers[w]->mutex);
+    m_workers[w]->ranges.push_back(r);
+}
+
+// most recent range of the own deque
+bool TaskScheduler::pop(unsigned w, range_t& r)
+{
+    worker_t& q = *m_workers[w];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.ranges.empty())
+        return false;
+    r = q.ranges.back();
+    q.ranges.pop_back();
+    return true;
+}
+
+// oldest range of another deque, visiting them from the next thread on
+bool TaskScheduler::steal(unsigned w, range_t& r)
+{
+    for (unsigned i = 1; i < m_n_threads; ++i) {
+        worker_t& q = *m_workers[(w + i) % m_n_threads];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (!q.ranges.empty()) {
+            r = q.ranges.front();
+            q.ranges.pop_front();
+            perf::count(perf::tasks_stolen);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::run_range(unsigned w, const range_t& r)
+{
+    perf::count(perf::tasks_run);
+    try {
+        (*m_body)(w, r.begin, r.end);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(m_error_mutex);
+        if (!m_error || r.begin < m_error_begin) {
+            m_error = std::current_exception();
+            m_error_begin = r.begin;
+        }
+    }
+}
+
+void TaskScheduler::run_worker(unsigned w)
+{
+    // count this thread in the hardware counters of the phases
+    if (perf::hw_enabled())
+        perf::this_thread_hw_counters();
+
+    range_t r;
+    while (m_remaining.load(std::memory_order_acquire) > 0) {
+        if (!pop(w, r) && !steal(w, r)) {
+            // the remaining ranges are running on other threads
+            std::this_thread::yield();
+            continue;
+        }
+        // split down to the grain, leaving the upper halves to this thread or to thieves
+        while (r.end - r.begin > m_grain) {
+            size_t mid = r.begin + (r.end - r.begin) / 2;
+            push(w, range_t{ mid, r.end });
+            r.end = mid;
+        }
+        run_range(w, r);
+        m_remaining.fetch_sub(r.end - r.begin, std::memory_order_acq_rel);
+    }
+}
+
+void TaskScheduler::serial_for(size_t n, size_t grain, const body_t& body)
+{
+    std::exception_ptr error;
+    for (size_t begin = 0; begin < n; begin += grain) {
+        perf::count(perf::tasks_run);
+        try {
+            body(0, begin, std::min(n, begin + grain));
+        } catch (...) {
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void TaskScheduler::parallel_for(size_t n, size_t grain, const body_t& body)
+{
+    grain = std::max<size_t>(grain, 1);
+    if (n == 0)
+        return;
+
+    std::unique_lock<std::mutex> loop(m_loop_mutex, std::defer_lock);
+    if (m_n_threads == 1 || n <= grain || t_in_task || !loop.try_lock()) {
+        serial_for(n, grain, body);
+        return;
+    }
+
+    m_body = &body;
+    m_grain = grain;
+    m_error = nullptr;
+    m_remaining.store(n, std::memory_order_relaxed);
+
+    // one contiguous range per thread
+    for (unsigned w = 0; w < m_n_threads; ++w) {
+        range_t r{ n * w / m_n_threads, n * (w + 1) / m_n_threads };
+        if (r.begin < r.end)
+            push(w, r);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_active = m_n_threads - 1;
+        ++m_generation;
+    }
+    m_start.notify_all();
+
+    t_in_task = true;
+    run_worker(0);
+    t_in_task = false;
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this] { return m_active == 0; });
+    }
+    m_body = nullptr;
+
+    if (m_error) {
+        std::exception_ptr error = m_error;
+        m_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+static std::unique_ptr<TaskScheduler> global_scheduler;
+static std::mutex global_mutex;
+
+TaskScheduler& TaskScheduler::global()
+{
+    std::lock_guard<std::mutex> lock(global_mutex);
+    if (!global_scheduler)
+        global_scheduler.reset(new TaskScheduler);
+    return *global_scheduler;
+}
+
+void TaskScheduler::set_global_threads(unsigned n_threads)
+{
+    std::lock_guard<std::mutex> lock(global_mutex);
+    global_scheduler.reset(new TaskScheduler(n_threads));
+}
+
+void TaskScheduler::set_global_threads_after_fork(unsigned n_threads)
+{
+    // the mutex is not locked: the calling thread is the only one in the process
+    global_scheduler.release();
+    global_scheduler.reset(new TaskScheduler(n_threads));
+}
+
+} // namespace minirisk
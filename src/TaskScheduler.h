@@ -0,0 +1,108 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <cstddef>
+
+namespace minirisk {
+
+// Work-stealing scheduler for loops of tasks of uneven cost (trades of different types, bump
+// scenarios). A loop over [0, n) starts with one contiguous range per thread. Each thread
+// splits its range in halves down to the grain size, running the lower half and pushing the
+// upper one on its own deque, from which it pops the most recent range first. A thread whose
+// deque is empty steals the oldest (hence largest) range of another thread.
+//
+// Which thread runs which range is not deterministic: the body must store its results by
+// position, and may use the worker index only to select per-thread scratch state.
+//
+// One loop runs at a time. A loop started while another one is running (from one of its
+// tasks, or from another thread) runs on the calling thread only.
+struct TaskScheduler
+{
+    // body of a loop: called with the index of the worker thread and a range [begin, end)
+    typedef std::function<void(unsigned worker, size_t begin, size_t end)> body_t;
+
+    // n_threads includes the thread calling parallel_for (0 for the hardware concurrency)
+    explicit TaskScheduler(unsigned n_threads = 0);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // number of threads, the caller included: worker indices are below this
+    unsigned n_threads() const { return m_n_threads; }
+
+    // Call body on ranges of at most grain elements covering [0, n), and return once all of
+    // them have run. If some calls throw, the exception of the range starting first is
+    // rethrown after all ranges have run.
+    void parallel_for(size_t n, size_t grain, const body_t& body);
+
+    // true on the threads running the tasks of a loop, where a nested loop would run serially
+    static bool in_task();
+
+    // scheduler used by the library, with the hardware concurrency unless set otherwise
+    static TaskScheduler& global();
+
+    // replace the global scheduler with one of n_threads threads (0 for the hardware
+    // concurrency); not to be called while the global scheduler is running a loop
+    static void set_global_threads(unsigned n_threads);
+
+    // Same as set_global_threads, in a child process created by fork: the threads of the
+    // inherited global scheduler only exist in the parent, so it is dropped without being
+    // joined (its memory is leaked)
+    static void set_global_threads_after_fork(unsigned n_threads);
+
+private:
+    struct range_t
+    {
+        size_t begin;
+        size_t end;
+    };
+
+    struct worker_t
+    {
+        std::mutex mutex;
+        std::deque<range_t> ranges;
+    };
+
+    void thread_main(unsigned w);
+    void run_worker(unsigned w);
+    bool pop(unsigned w, range_t& r);
+    bool steal(unsigned w, range_t& r);
+    void push(unsigned w, const range_t& r);
+    void run_range(unsigned w, const range_t& r);
+    void serial_for(size_t n, size_t grain, const body_t& body);
+
+    unsigned m_n_threads;
+    std::vector<std::unique_ptr<worker_t>> m_workers;   // deques, the calling thread's first
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_loop_mutex;            // held while a loop runs
+
+    // wakes up the threads for a new loop, and waits for them at its end
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    unsigned m_generation;
+    unsigned m_active;
+    bool m_stop;
+
+    // loop being run
+    const body_t* m_body;
+    size_t m_grain;
+    std::atomic<size_t> m_remaining;    // elements not run yet
+
+    // first error of the loop, by position
+    std::mutex m_error_mutex;
+    std::exception_ptr m_error;
+    size_t m_error_begin;
+};
+
+} // namespace minirisk
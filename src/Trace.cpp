@@ -0,0 +1,144 @@
+#include "Trace.h"
+
+#include <chrono>
+#include <iomanip>
+#include <unistd.h>
+
+namespace minirisk {
+namespace trace {
+
+std::atomic<bool> g_enabled(false);
+
+namespace {
+
+struct event_t
+{
+    string name;
+    const char* category;
+    string detail;
+    int64_t begin;
+    int64_t end;
+};
+
+// Events are stored in fixed size chunks which are never moved, so that the reader can walk
+// them while the owner thread keeps appending. The owner publishes each event by incrementing
+// the chunk size (release), the reader only looks at events below the size it observes (acquire).
+struct chunk_t
+{
+    static const size_t capacity = 4096;
+    event_t events[capacity];
+    std::atomic<size_t> size{ 0 };
+    std::atomic<chunk_t*> next{ nullptr };
+};
+
+// Events of one thread. Buffers are linked in a global list and live until the end of
+// the process, so that the events of finished threads are kept.
+struct thread_buffer_t
+{
+    explicit thread_buffer_t(unsigned tid) : tid(tid), head(new chunk_t), tail(head) {}
+
+    void push(event_t&& e)
+    {
+        size_t n = tail->size.load(std::memory_order_relaxed);
+        if (n == chunk_t::capacity) {
+            chunk_t* c = new chunk_t;
+            tail->next.store(c, std::memory_order_release);
+            tail = c;
+            n = 0;
+        }
+        tail->events[n] = std::move(e);
+        tail->size.store(n + 1, std::memory_order_release);
+    }
+
+    const unsigned tid;
+    chunk_t* const head;
+    chunk_t* tail;       // only accessed by the owner thread
+    thread_buffer_t* next = nullptr;
+};
+
+std::atomic<thread_buffer_t*> buffers(nullptr);
+std::atomic<unsigned> n_threads(0);
+const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+thread_buffer_t& this_thread_buffer()
+{
+    thread_local thread_buffer_t* buf = nullptr;
+    if (!buf) {
+        buf = new thread_buffer_t(n_threads++);
+        // lock-free push at the front of the list of buffers
+        buf->next = buffers.load(std::memory_order_relaxed);
+        while (!buffers.compare_exchange_weak(buf->next, buf, std::memory_order_release, std::memory_order_relaxed))
+            ;
+    }
+    return *buf;
+}
+
+void write_string(std::ostream& os, const string& s)
+{
+    os << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            os << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20)
+            os << ' ';
+        else
+            os << c;
+    }
+    os << '"';
+}
+
+} // namespace
+
+void enable(bool on)
+{
+    g_enabled.store(on, std::memory_order_relaxed);
+}
+
+int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void add_event(string&& name, const char* category, string&& detail, int64_t begin, int64_t end)
+{
+    this_thread_buffer().push(event_t{ std::move(name), category, std::move(detail), begin, end });
+}
+
+void write_json(std::ostream& os)
+{
+    std::ios_base::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(3);
+
+    const int pid = static_cast<int>(::getpid());
+    bool first = true;
+
+    os << "{\"traceEvents\":[";
+    for (thread_buffer_t* b = buffers.load(std::memory_order_acquire); b; b = b->next) {
+        os << (first ? "\n" : ",\n")
+           << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << b->tid
+           << ",\"args\":{\"name\":\"thread " << b->tid << "\"}}";
+        first = false;
+        for (const chunk_t* c = b->head; c; c = c->next.load(std::memory_order_acquire)) {
+            size_t n = c->size.load(std::memory_order_acquire);
+            for (size_t i = 0; i < n; ++i) {
+                const event_t& e = c->events[i];
+                os << ",\n{\"name\":";
+                write_string(os, e.name);
+                os << ",\"cat\":\"" << e.category << "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << b->tid
+                   << ",\"ts\":" << e.begin * 1e-3 << ",\"dur\":" << (e.end - e.begin) * 1e-3;
+                if (!e.detail.empty()) {
+                    os << ",\"args\":{\"detail\":";
+                    write_string(os, e.detail);
+                    os << "}";
+                }
+                os << "}";
+            }
+        }
+    }
+    os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    os.flags(flags);
+}
+
+} // namespace trace
+} // namespace minirisk
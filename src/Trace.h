@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+
+#include "Global.h"
+
+namespace minirisk {
+
+// Timeline tracing: scoped events written in the Chrome trace event format, which can be
+// opened in chrome://tracing or https://ui.perfetto.dev.
+// Tracing is disabled by default, in which case each probe costs one relaxed atomic load
+// and a branch. When enabled, each thread appends to its own buffer without locking.
+namespace trace {
+
+extern std::atomic<bool> g_enabled;
+
+inline bool enabled()
+{
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+// turn tracing on or off (recorded events are kept)
+void enable(bool on = true);
+
+// nanoseconds since tracing was first enabled
+int64_t now();
+
+// record a complete event on the calling thread's buffer
+void add_event(string&& name, const char* category, string&& detail, int64_t begin, int64_t end);
+
+// records the enclosing scope as one event of the calling thread.
+// The detail (e.g. a file name) is shown among the arguments of the event.
+struct ScopedEvent
+{
+    ScopedEvent(const char* name, const char* category)
+        : m_category(enabled() ? category : nullptr)
+    {
+        if (m_category) {
+            m_name = name;
+            m_begin = now();
+        }
+    }
+
+    ScopedEvent(const string& name, const char* category, const string& detail = string())
+        : m_category(enabled() ? category : nullptr)
+    {
+        if (m_category) {
+            m_name = name;
+            m_detail = detail;
+            m_begin = now();
+        }
+    }
+
+    ~ScopedEvent()
+    {
+        if (m_category)
+            add_event(std::move(m_name), m_category, std::move(m_detail), m_begin, now());
+    }
+
+    ScopedEvent(const ScopedEvent&) = delete;
+    ScopedEvent& operator=(const ScopedEvent&) = delete;
+
+private:
+    const char* m_category;
+    string m_name;
+    string m_detail;
+    int64_t m_begin;
+};
+
+// Write all the recorded events as a Chrome trace JSON document.
+// Events still being recorded by other threads may or may not be included.
+void write_json(std::ostream& os);
+
+} // namespace trace
+
+} // namespace minirisk
@@ -2,6 +2,7 @@
 
 #include "ITrade.h"
 #include "Streamer.h"
+#include "ReportWriter.h"
 #include "Macros.h"
 #include <cmath>
 
@@ -34,11 +35,17 @@ struct Trade : ITrade
 protected:
     virtual void print(std::ostream& os) const
     {
-        os << format_label("Id") << id() << std::endl;
-        os << format_label("Name") << idname() << std::endl;
-        os << format_label("Quantity") << quantity() << std::endl;
-        static_cast<const T*>(this)->print_details(os);
-        os << std::endl;
+        ReportWriter w(os);
+        print(w);
+    }
+
+    virtual void print(ReportWriter& w) const
+    {
+        w.label("Id") << id() << '\n';
+        w.label("Name") << idname() << '\n';
+        w.label("Quantity") << quantity() << '\n';
+        static_cast<const T*>(this)->print_details(w);
+        w << '\n';
     }
 
     virtual void save(my_ofstream& os) const
@@ -10,7 +10,7 @@ struct TradeFXForward : Trade<TradeFXForward>
 {
     friend struct Trade<TradeFXForward>;
 
-    static const guid_t m_id;
+    static constexpr guid_t m_id = 3;
     static const std::string m_name;
 
     TradeFXForward() {}
@@ -37,8 +37,8 @@ struct TradeFXForward : Trade<TradeFXForward>
         MYASSERT(fixing_date <= settle_date, "Fixing date must be less than or equal to settlement date");
         
         Trade::init(notional);
-        m_ccy1 = ccy1;
-        m_ccy2 = ccy2;
+        m_ccy1 = Ccy(ccy1);
+        m_ccy2 = Ccy(ccy2);
         m_strike = strike;
         m_fixing_date = fixing_date;
         m_settle_date = settle_date;
@@ -46,12 +46,12 @@ struct TradeFXForward : Trade<TradeFXForward>
 
     virtual ppricer_t pricer(const std::string& configuration) const;
 
-    const std::string& ccy1() const
+    Ccy ccy1() const
     {
         return m_ccy1;
     }
 
-    const std::string& ccy2() const
+    Ccy ccy2() const
     {
         return m_ccy2;
     }
@@ -82,18 +82,18 @@ private:
         is >> m_ccy1 >> m_ccy2 >> m_strike >> m_fixing_date >> m_settle_date;
     }
 
-    void print_details(std::ostream& os) const
+    void print_details(ReportWriter& w) const
     {
-        os << format_label("Strike level") << m_strike << std::endl;
-        os << format_label("Base Currency") << m_ccy1 << std::endl;
-        os << format_label("Quote Currency") << m_ccy2 << std::endl;
-        os << format_label("Fixing Date") << m_fixing_date << std::endl;
-        os << format_label("Settlement Date") << m_settle_date << std::endl;
+        w.label("Strike level") << m_strike << '\n';
+        w.label("Base Currency") << m_ccy1 << '\n';
+        w.label("Quote Currency") << m_ccy2 << '\n';
+        w.label("Fixing Date") << m_fixing_date << '\n';
+        w.label("Settlement Date") << m_settle_date << '\n';
     }
 
 private:
-    std::string m_ccy1;
-    std::string m_ccy2;
+    Ccy m_ccy1;
+    Ccy m_ccy2;
     double m_strike;
     Date m_fixing_date;
     Date m_settle_date;
@@ -10,7 +10,7 @@ struct TradePayment : Trade<TradePayment>
 {
     friend struct Trade<TradePayment>;
 
-    static const guid_t m_id;
+    static constexpr guid_t m_id = 0;
     static const std::string m_name;
 
     TradePayment() {}
@@ -28,13 +28,13 @@ struct TradePayment : Trade<TradePayment>
         // The Date constructor will throw if invalid, so we just need to ensure it's not default-constructed
         
         Trade::init(quantity);
-        m_ccy = ccy;
+        m_ccy = Ccy(ccy);
         m_delivery_date = delivery_date;
     }
 
     virtual ppricer_t pricer(const std::string& configuration) const;
 
-    const string& ccy() const
+    Ccy ccy() const
     {
         return m_ccy;
     }
@@ -55,14 +55,14 @@ private:
         is >> m_ccy >> m_delivery_date;
     }
 
-    void print_details(std::ostream& os) const
+    void print_details(ReportWriter& w) const
     {
-        os << format_label("Currency") << m_ccy << std::endl;
-        os << format_label("Delivery Date") << m_delivery_date << std::endl;
+        w.label("Currency") << m_ccy << '\n';
+        w.label("Delivery Date") << m_delivery_date << '\n';
     }
 
 private:
-    string m_ccy;
+    Ccy m_ccy;
     Date m_delivery_date;
 };
 
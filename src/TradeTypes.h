@@ -0,0 +1,129 @@
+#pragma once
+
+#include <vector>
+#include <tuple>
+#include <typeinfo>
+
+#include "ITrade.h"
+#include "IPricer.h"
+#include "TradePayment.h"
+#include "TradeFXForward.h"
+#include "PricerPayment.h"
+#include "PricerFXForward.h"
+
+namespace minirisk {
+
+// Compile-time registry of the trade types, each with the pricer it creates. Loading,
+// and grouping pricers into homogeneous batches, are generated from this list: adding a
+// trade type means adding it here. Trades and pricers of types not listed here still work
+// through the ITrade and IPricer interfaces, they are just priced with virtual calls.
+
+template <typename T, typename P>
+struct trade_type
+{
+    typedef T trade_t;
+    typedef P pricer_t;
+};
+
+template <typename... Ts>
+struct type_list {};
+
+typedef type_list<
+    trade_type<TradePayment, PricerPayment>,
+    trade_type<TradeFXForward, PricerFXForward>
+> trade_types_t;
+
+namespace detail {
+
+template <typename... Ts>
+constexpr bool unique_ids(type_list<Ts...>)
+{
+    constexpr guid_t ids[] = { Ts::trade_t::m_id... };
+    for (size_t i = 0; i < sizeof...(Ts); ++i)
+        for (size_t j = i + 1; j < sizeof...(Ts); ++j)
+            if (ids[i] == ids[j])
+                return false;
+    return true;
+}
+
+template <typename... Ts>
+ptrade_t new_trade(guid_t id, type_list<Ts...>)
+{
+    ptrade_t p;
+    ((id == Ts::trade_t::m_id && (p.reset(new typename Ts::trade_t), true)) || ...);
+    return p;
+}
+
+} // namespace detail
+
+static_assert(detail::unique_ids(trade_types_t()), "Trade type ids must be unique");
+
+// new empty trade of the type with identifier id, or null if the type is not registered
+inline ptrade_t new_trade(guid_t id)
+{
+    return detail::new_trade(id, trade_types_t());
+}
+
+// Pricers of one concrete type and their position in the portfolio. As the registered
+// pricers are final, calls through a batch are resolved at compile time.
+template <typename P>
+struct pricer_batch_t
+{
+    std::vector<size_t> index;
+    std::vector<const P*> pricers;
+
+    size_t size() const { return pricers.size(); }
+};
+
+template <typename List>
+struct pricer_batches_base_t;
+
+template <typename... Ts>
+struct pricer_batches_base_t<type_list<Ts...>>
+{
+    // Group pricers by type. The pricers must outlive the batches.
+    explicit pricer_batches_base_t(const std::vector<ppricer_t>& pricers)
+        : m_size(pricers.size())
+    {
+        for (size_t i = 0; i < pricers.size(); ++i) {
+            const IPricer* p = pricers[i].get();
+            const std::type_info& type = typeid(*p);
+            bool found = (add<typename Ts::pricer_t>(type, p, i) || ...);
+            if (!found) {
+                m_other.index.push_back(i);
+                m_other.pricers.push_back(p);
+            }
+        }
+    }
+
+    // number of pricers
+    size_t size() const { return m_size; }
+
+    // call f on each batch: one per registered type, then the unregistered pricers
+    template <typename F>
+    void for_each(F&& f) const
+    {
+        std::apply([&f](const auto&... b) { (f(b), ...); }, m_batches);
+        f(m_other);
+    }
+
+private:
+    template <typename P>
+    bool add(const std::type_info& type, const IPricer* p, size_t i)
+    {
+        if (type != typeid(P))
+            return false;
+        auto& b = std::get<pricer_batch_t<P>>(m_batches);
+        b.index.push_back(i);
+        b.pricers.push_back(static_cast<const P*>(p));
+        return true;
+    }
+
+    size_t m_size;
+    std::tuple<pricer_batch_t<typename Ts::pricer_t>...> m_batches;
+    pricer_batch_t<IPricer> m_other;
+};
+
+typedef pricer_batches_base_t<trade_types_t> pricer_batches_t;
+
+} // namespace minirisk